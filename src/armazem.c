@@ -0,0 +1,729 @@
+/**
+*@file armazem.c
+\brief Módulo do ARMAZEM, o ficheiro único onde são guardados os utilizadores.
+
+O ficheiro é dividido em páginas de @c PAGINA bytes. A página 0 tem o @c TOPO , as @c NBALDES
+páginas seguintes são os baldes do índice, escolhidos por dispersão da chave, e as restantes
+guardam os valores, em cadeias de páginas de dados, ou continuações dos baldes.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "armazem.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// ------------------------------------------------------------------------------
+
+/* Metódos públicos */
+ARMAZEM abreA(char *ficheiro);
+void fechaA(ARMAZEM a);
+char *leA(ARMAZEM a, char *chave, size_t *tam);
+int leParteA(ARMAZEM a, char *chave, size_t off, char *buf, size_t tam, size_t *total);
+int escreveA(ARMAZEM a, char *chave, const char *buf, size_t tam);
+int acrescentaA(ARMAZEM a, char *chave, const char *buf, size_t tam);
+int apagaA(ARMAZEM a, char *chave);
+int trancaA(ARMAZEM a, char *chave, int exclusivo);
+int destrancaA(ARMAZEM a, char *chave);
+ARMAZEM armazem(char *path);
+void fechaArmazem();
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Tamanho de uma página do ficheiro.
+*/
+#define PAGINA 4096
+
+/**
+\brief Identificador no início do ficheiro do armazém.
+*/
+#define A_MAGIC "GGDB"
+
+/**
+\brief Versão do formato do ficheiro do armazém.
+*/
+#define A_VERSAO 1
+
+/**
+\brief Número de baldes do índice de um armazém novo.
+*/
+#define NBALDES 1024
+
+/**
+\brief Início da zona do ficheiro usada para trancar chaves, muito para lá da última página.
+Cada chave é trancada num byte desta zona, escolhido por dispersão, que nunca é escrito.
+*/
+#define ZONA_TRANCAS ((off_t)1 << 40)
+
+/**
+\brief Cabeçalho do ficheiro, guardado na página 0.
+*/
+typedef struct topo
+{
+	char magic[4];           /**< A_MAGIC */
+	int32_t versao;          /**< A_VERSAO */
+	int32_t npags;           /**< Número de páginas do ficheiro */
+	int32_t nbaldes;         /**< Número de baldes do índice */
+	int32_t livre;           /**< Primeira página da lista de páginas livres, ou 0 */
+} TOPO;
+
+/**
+\brief Entrada do índice, que associa uma chave à cadeia de páginas com o seu valor.
+*/
+typedef struct entrada
+{
+	char chave[MAX_CHAVE];   /**< Chave */
+	int32_t primeira;        /**< Primeira página do valor, ou 0 */
+	int32_t ultima;          /**< Última página do valor, ou 0 */
+	int32_t tam;             /**< Tamanho do valor, em bytes */
+	int32_t pad;             /**< Alinhamento */
+} ENTRADA;
+
+/**
+\brief Número de entradas numa página de um balde.
+*/
+#define NENTRADAS ((PAGINA - 2 * sizeof(int32_t)) / sizeof(ENTRADA))
+
+/**
+\brief Página de um balde do índice.
+*/
+typedef struct balde
+{
+	int32_t seguinte;        /**< Página de continuação do balde, ou 0 */
+	int32_t n;               /**< Número de entradas ocupadas */
+	ENTRADA e[NENTRADAS];    /**< Entradas */
+} BALDE;
+
+/**
+\brief Número de bytes de um valor guardados numa página de dados.
+*/
+#define NDADOS (PAGINA - 2 * sizeof(int32_t))
+
+/**
+\brief Página de dados.
+*/
+typedef struct dados
+{
+	int32_t seguinte;        /**< Página seguinte do valor, ou 0 */
+	int32_t usado;           /**< Número de bytes ocupados */
+	char d[NDADOS];          /**< Dados */
+} DADOS;
+
+/**
+\brief Estrutura do armazém aberto.
+*/
+struct armazem
+{
+	int fd;                  /**< Descritor do ficheiro */
+	int nbaldes;             /**< Número de baldes do índice */
+	int sujo;                /**< Indica se houve escritas desde que foi aberto */
+};
+
+/**
+\brief Armazém dos utilizadores, aberto por @c armazem .
+*/
+static ARMAZEM principal = NULL;
+
+/**
+\brief Diretória de @c principal .
+*/
+static char *pathPrincipal = NULL;
+
+/* Metódos privados */
+static uint32_t dispersao(char *chave);
+static int trancarBytes(ARMAZEM a, off_t inicio, off_t tam, int tipo);
+static int trancar(ARMAZEM a, int pag, int tipo);
+static int lePag(ARMAZEM a, int pag, void *buf, size_t tam);
+static int escrevePag(ARMAZEM a, int pag, const void *buf, size_t tam);
+static int aloca(ARMAZEM a, int n, int32_t *pags);
+static void liberta(ARMAZEM a, int primeira);
+static int escreveDados(ARMAZEM a, const char *buf, size_t tam, int32_t *primeira, int32_t *ultima);
+static int procura(ARMAZEM a, char *chave, int cria, BALDE *b, int *pag, int *k);
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Função de dispersão das chaves (FNV-1a).
+
+@param chave Chave.
+
+@returns O valor de dispersão.
+*/
+static uint32_t dispersao(char *chave)
+{
+	uint32_t h = 2166136261u;
+	for (; *chave; chave++)
+		h = (h ^ (unsigned char)*chave) * 16777619u;
+	return h;
+}
+
+/**
+\brief Tranca ou destranca uma zona do ficheiro, esperando caso esteja trancada por outro processo.
+
+@param a Armazém.
+@param inicio Posição do primeiro byte.
+@param tam Número de bytes.
+@param tipo @c F_RDLCK , @c F_WRLCK ou @c F_UNLCK .
+
+@returns O resultado de @c fcntl .
+*/
+static int trancarBytes(ARMAZEM a, off_t inicio, off_t tam, int tipo)
+{
+	struct flock fl;
+	memset(&fl, 0, sizeof(fl));
+	fl.l_type = tipo;
+	fl.l_whence = SEEK_SET;
+	fl.l_start = inicio;
+	fl.l_len = tam;
+	return fcntl(a->fd, F_SETLKW, &fl);
+}
+
+/**
+\brief Tranca ou destranca uma página do ficheiro.
+
+@param a Armazém.
+@param pag Número da página.
+@param tipo @c F_RDLCK , @c F_WRLCK ou @c F_UNLCK .
+
+@returns O resultado de @c fcntl .
+
+@see trancarBytes
+*/
+static int trancar(ARMAZEM a, int pag, int tipo)
+{
+	return trancarBytes(a, (off_t)pag * PAGINA, PAGINA, tipo);
+}
+
+/**
+\brief Lê o início de uma página. O que estiver para lá do fim do ficheiro é lido como zeros.
+
+@param a Armazém.
+@param pag Número da página.
+@param buf Onde é colocada a página.
+@param tam Número de bytes a ler.
+
+@returns O número de bytes que existiam no ficheiro, ou -1 em caso de erro.
+*/
+static int lePag(ARMAZEM a, int pag, void *buf, size_t tam)
+{
+	ssize_t r = pread(a->fd, buf, tam, (off_t)pag * PAGINA);
+	if (r < 0)
+		return -1;
+	memset((char *)buf + r, 0, tam - r);
+	return r;
+}
+
+/**
+\brief Escreve o início de uma página.
+
+@param a Armazém.
+@param pag Número da página.
+@param buf Conteúdo da página.
+@param tam Número de bytes a escrever.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+static int escrevePag(ARMAZEM a, int pag, const void *buf, size_t tam)
+{
+	a->sujo = 1;
+	return (pwrite(a->fd, buf, tam, (off_t)pag * PAGINA) == (ssize_t)tam) ? 0 : -1;
+}
+
+/**
+\brief Reserva páginas, retirando-as da lista de páginas livres ou acrescentando-as ao ficheiro.
+A página 0 fica trancada durante a operação.
+
+@param a Armazém.
+@param n Número de páginas.
+@param pags Array onde são colocados os números das páginas.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+static int aloca(ARMAZEM a, int n, int32_t *pags)
+{
+	TOPO t;
+	int i, r;
+
+	trancar(a, 0, F_WRLCK);
+	r = lePag(a, 0, &t, sizeof(TOPO));
+	for (i = 0; r >= 0 && i < n; i++)
+		if (t.livre)
+		{
+			pags[i] = t.livre;
+			r = lePag(a, t.livre, &t.livre, sizeof(int32_t));
+		}
+		else
+			pags[i] = t.npags++;
+	if (r >= 0)
+		r = escrevePag(a, 0, &t, sizeof(TOPO));
+	trancar(a, 0, F_UNLCK);
+	return (r < 0) ? -1 : 0;
+}
+
+/**
+\brief Devolve uma cadeia de páginas à lista de páginas livres.
+
+@param a Armazém.
+@param primeira Primeira página da cadeia, ou 0.
+*/
+static void liberta(ARMAZEM a, int primeira)
+{
+	TOPO t;
+	int32_t ultima = primeira, seguinte;
+
+	if (!primeira)
+		return;
+	while (lePag(a, ultima, &seguinte, sizeof(int32_t)) > 0 && seguinte)
+		ultima = seguinte;
+
+	trancar(a, 0, F_WRLCK);
+	if (lePag(a, 0, &t, sizeof(TOPO)) > 0 && !escrevePag(a, ultima, &t.livre, sizeof(int32_t)))
+	{
+		t.livre = primeira;
+		escrevePag(a, 0, &t, sizeof(TOPO));
+	}
+	trancar(a, 0, F_UNLCK);
+}
+
+/**
+\brief Escreve um valor numa nova cadeia de páginas de dados.
+
+@param a Armazém.
+@param buf Valor.
+@param tam Tamanho do valor.
+@param primeira Onde é colocada a primeira página da cadeia.
+@param ultima Onde é colocada a última página da cadeia.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+static int escreveDados(ARMAZEM a, const char *buf, size_t tam, int32_t *primeira, int32_t *ultima)
+{
+	int i, r, n = (tam + NDADOS - 1) / NDADOS;
+	int32_t *pags;
+	DADOS p;
+
+	*primeira = *ultima = 0;
+	if (n == 0)
+		return 0;
+	pags = malloc(sizeof(int32_t) * n);
+	r = aloca(a, n, pags);
+	for (i = 0; !r && i < n; i++)
+	{
+		p.seguinte = (i + 1 < n) ? pags[i + 1] : 0;
+		p.usado = (tam - i * NDADOS < NDADOS) ? tam - i * NDADOS : NDADOS;
+		memcpy(p.d, buf + i * NDADOS, p.usado);
+		r = escrevePag(a, pags[i], &p, 2 * sizeof(int32_t) + p.usado);
+	}
+	if (!r)
+	{
+		*primeira = pags[0];
+		*ultima = pags[n - 1];
+	}
+	free(pags);
+	return r;
+}
+
+/**
+\brief Procura a entrada de uma chave no seu balde, que deve estar trancado.
+
+@param a Armazém.
+@param chave Chave.
+@param cria Caso a chave não exista e @p cria seja diferente de 0, é preparada uma entrada
+vazia para a chave, que só fica no ficheiro quando a página for escrita.
+@param b Onde é colocada a página do balde com a entrada.
+@param pag Onde é colocado o número dessa página.
+@param k Onde é colocada a posição da entrada na página.
+
+@returns 1 caso a chave exista, 0 caso não exista e -1 em caso de erro.
+*/
+static int procura(ARMAZEM a, char *chave, int cria, BALDE *b, int *pag, int *k)
+{
+	int32_t nova;
+	int comEspaco = 0;
+
+	*pag = 1 + dispersao(chave) % a->nbaldes;
+	while (1)
+	{
+		if (lePag(a, *pag, b, sizeof(BALDE)) < 0 || b->n < 0 || b->n > (int)NENTRADAS)
+			return -1;
+		for (*k = 0; *k < b->n; (*k)++)
+			if (!strncmp(b->e[*k].chave, chave, MAX_CHAVE))
+				return 1;
+		if (!comEspaco && b->n < (int)NENTRADAS)
+			comEspaco = *pag;
+		if (!b->seguinte)
+			break;
+		*pag = b->seguinte;
+	}
+	if (!cria)
+		return 0;
+
+	if (comEspaco)
+	{
+		*pag = comEspaco;
+		lePag(a, *pag, b, sizeof(BALDE));
+	}
+	else
+	{
+		if (aloca(a, 1, &nova))
+			return -1;
+		b->seguinte = nova;
+		if (escrevePag(a, *pag, b, sizeof(BALDE)))
+			return -1;
+		memset(b, 0, sizeof(BALDE));
+		*pag = nova;
+	}
+	*k = b->n++;
+	memset(&b->e[*k], 0, sizeof(ENTRADA));
+	strncpy(b->e[*k].chave, chave, MAX_CHAVE - 1);
+	return 0;
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Abre o ficheiro de um armazém, criando-o caso não exista.
+
+@param ficheiro Caminho do ficheiro.
+
+@returns O armazém, ou NULL caso o ficheiro não possa ser aberto ou não seja um armazém.
+*/
+ARMAZEM abreA(char *ficheiro)
+{
+	ARMAZEM a;
+	TOPO t;
+	int r, fd = open(ficheiro, O_RDWR | O_CREAT, 0660);
+
+	if (fd < 0)
+		return NULL;
+	a = malloc(sizeof(struct armazem));
+	a->fd = fd;
+	a->sujo = 0;
+
+	trancar(a, 0, F_WRLCK);
+	r = lePag(a, 0, &t, sizeof(TOPO));
+	if (r == 0)
+	{
+		memcpy(t.magic, A_MAGIC, 4);
+		t.versao = A_VERSAO;
+		t.nbaldes = NBALDES;
+		t.npags = 1 + NBALDES;
+		t.livre = 0;
+		if (ftruncate(fd, (off_t)t.npags * PAGINA) || escrevePag(a, 0, &t, sizeof(TOPO)))
+			r = -1;
+	}
+	else if (r < (int)sizeof(TOPO) || memcmp(t.magic, A_MAGIC, 4) || t.versao != A_VERSAO || t.nbaldes <= 0)
+		r = -1;
+	trancar(a, 0, F_UNLCK);
+
+	if (r < 0)
+	{
+		close(fd);
+		free(a);
+		return NULL;
+	}
+	a->nbaldes = t.nbaldes;
+	return a;
+}
+
+/**
+\brief Fecha um armazém. Caso tenha havido escritas, o ficheiro é sincronizado com um só @c fsync .
+
+@param a Armazém.
+*/
+void fechaA(ARMAZEM a)
+{
+	if (a->sujo)
+		fsync(a->fd);
+	close(a->fd);
+	free(a);
+}
+
+/**
+\brief Lê o valor associado a uma chave.
+
+@param a Armazém.
+@param chave Chave.
+@param tam Onde é colocado o tamanho do valor.
+
+@returns O valor, que deve ser libertado com @c free , ou NULL caso a chave não exista.
+*/
+char *leA(ARMAZEM a, char *chave, size_t *tam)
+{
+	BALDE b;
+	DADOS p;
+	char *buf = NULL;
+	int pag, k, balde = 1 + dispersao(chave) % a->nbaldes;
+	size_t off = 0, m;
+	int32_t seguinte;
+
+	trancar(a, balde, F_RDLCK);
+	if (procura(a, chave, 0, &b, &pag, &k) == 1)
+	{
+		*tam = b.e[k].tam;
+		buf = malloc(*tam + 1);
+		for (seguinte = b.e[k].primeira; seguinte && off < *tam; seguinte = p.seguinte)
+		{
+			if (lePag(a, seguinte, &p, sizeof(DADOS)) < 0)
+				break;
+			m = ((size_t)p.usado < *tam - off) ? (size_t)p.usado : *tam - off;
+			memcpy(buf + off, p.d, m);
+			off += m;
+		}
+		if (off < *tam)
+		{
+			free(buf);
+			buf = NULL;
+		}
+	}
+	trancar(a, balde, F_UNLCK);
+	return buf;
+}
+
+/**
+\brief Lê parte do valor associado a uma chave.
+
+As páginas anteriores à parte pedida são saltadas lendo apenas o seu cabeçalho,
+pelo que não é copiado nada para lá da parte pedida.
+
+@param a Armazém.
+@param chave Chave.
+@param off Posição, no valor, do primeiro byte a ler.
+@param buf Onde é colocada a parte lida.
+@param tam Número de bytes a ler.
+@param total Onde é colocado o tamanho do valor, caso não seja NULL.
+
+@returns 0 caso a parte tenha sido lida, -1 caso a chave não exista ou o valor seja mais curto.
+*/
+int leParteA(ARMAZEM a, char *chave, size_t off, char *buf, size_t tam, size_t *total)
+{
+	BALDE b;
+	int32_t cab[2], pag;
+	int k, r = -1, balde = 1 + dispersao(chave) % a->nbaldes;
+	size_t m;
+
+	trancar(a, balde, F_RDLCK);
+	if (procura(a, chave, 0, &b, &pag, &k) == 1)
+	{
+		if (total)
+			*total = b.e[k].tam;
+		if (off + tam <= (size_t)b.e[k].tam)
+		{
+			for (pag = b.e[k].primeira; pag && tam && lePag(a, pag, cab, sizeof(cab)) > 0; pag = cab[0])
+			{
+				if (off >= (size_t)cab[1])
+				{
+					off -= cab[1];
+					continue;
+				}
+				m = ((size_t)cab[1] - off < tam) ? (size_t)cab[1] - off : tam;
+				if (pread(a->fd, buf, m, (off_t)pag * PAGINA + sizeof(cab) + off) != (ssize_t)m)
+					break;
+				buf += m;
+				tam -= m;
+				off = 0;
+			}
+			r = tam ? -1 : 0;
+		}
+	}
+	trancar(a, balde, F_UNLCK);
+	return r;
+}
+
+/**
+\brief Associa um valor a uma chave, substituindo o valor anterior.
+
+O valor é escrito numa nova cadeia de páginas, e só depois a entrada passa a apontar para ela,
+pelo que o valor anterior se mantém caso a escrita seja interrompida.
+
+@param a Armazém.
+@param chave Chave, com menos de @c MAX_CHAVE caracteres.
+@param buf Valor.
+@param tam Tamanho do valor.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+int escreveA(ARMAZEM a, char *chave, const char *buf, size_t tam)
+{
+	BALDE b;
+	int pag, k, r, balde = 1 + dispersao(chave) % a->nbaldes;
+	int32_t antiga;
+
+	if (strlen(chave) >= MAX_CHAVE)
+		return -1;
+	trancar(a, balde, F_WRLCK);
+	r = procura(a, chave, 1, &b, &pag, &k);
+	if (r >= 0)
+	{
+		antiga = b.e[k].primeira;
+		r = escreveDados(a, buf, tam, &b.e[k].primeira, &b.e[k].ultima);
+		b.e[k].tam = tam;
+		if (!r && !(r = escrevePag(a, pag, &b, sizeof(BALDE))))
+			liberta(a, antiga);
+	}
+	trancar(a, balde, F_UNLCK);
+	return (r < 0) ? -1 : 0;
+}
+
+/**
+\brief Acrescenta dados ao fim do valor associado a uma chave.
+A última página do valor é completada e as restantes são acrescentadas à cadeia.
+
+@param a Armazém.
+@param chave Chave, com menos de @c MAX_CHAVE caracteres.
+@param buf Dados a acrescentar.
+@param tam Tamanho dos dados.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+int acrescentaA(ARMAZEM a, char *chave, const char *buf, size_t tam)
+{
+	BALDE b;
+	DADOS p;
+	ENTRADA *e;
+	size_t m = 0;
+	int pag, k, r, balde = 1 + dispersao(chave) % a->nbaldes;
+	int32_t primeira, ultima;
+
+	if (strlen(chave) >= MAX_CHAVE)
+		return -1;
+	trancar(a, balde, F_WRLCK);
+	r = procura(a, chave, 1, &b, &pag, &k);
+	e = &b.e[(r < 0) ? 0 : k];
+	if (r >= 0 && e->ultima && (r = lePag(a, e->ultima, &p, sizeof(DADOS))) >= 0)
+	{
+		m = (NDADOS - p.usado < tam) ? NDADOS - p.usado : tam;
+		memcpy(p.d + p.usado, buf, m);
+		p.usado += m;
+	}
+	if (r >= 0 && !(r = escreveDados(a, buf + m, tam - m, &primeira, &ultima)))
+	{
+		if (e->ultima)
+		{
+			if (primeira)
+				p.seguinte = primeira;
+			r = escrevePag(a, e->ultima, &p, 2 * sizeof(int32_t) + p.usado);
+		}
+		else
+			e->primeira = primeira;
+		if (ultima)
+			e->ultima = ultima;
+		e->tam += tam;
+		if (!r)
+			r = escrevePag(a, pag, &b, sizeof(BALDE));
+	}
+	trancar(a, balde, F_UNLCK);
+	return (r < 0) ? -1 : 0;
+}
+
+/**
+\brief Remove uma chave e o seu valor.
+
+@param a Armazém.
+@param chave Chave.
+
+@returns 1 caso a chave tenha sido removida, 0 caso não exista e -1 em caso de erro.
+*/
+int apagaA(ARMAZEM a, char *chave)
+{
+	BALDE b;
+	int pag, k, r, balde = 1 + dispersao(chave) % a->nbaldes;
+	int32_t antiga;
+
+	trancar(a, balde, F_WRLCK);
+	r = procura(a, chave, 0, &b, &pag, &k);
+	if (r == 1)
+	{
+		antiga = b.e[k].primeira;
+		b.e[k] = b.e[--b.n];
+		if (escrevePag(a, pag, &b, sizeof(BALDE)))
+			r = -1;
+		else
+			liberta(a, antiga);
+	}
+	trancar(a, balde, F_UNLCK);
+	return r;
+}
+
+/**
+\brief Tranca uma chave, para que uma sequência de leituras e escritas não se misture com as de outro processo.
+
+A tranca é apenas indicativa: @c leA e @c escreveA não a verificam. Várias trancas partilhadas
+podem coexistir, mas uma tranca exclusiva espera que todas as outras sejam libertadas.
+As trancas são libertadas por @c destrancaA ou quando o armazém é fechado.
+
+@param a Armazém.
+@param chave Chave a trancar, que não precisa de existir.
+@param exclusivo Diferente de 0 para uma tranca exclusiva, 0 para uma tranca partilhada.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+int trancaA(ARMAZEM a, char *chave, int exclusivo)
+{
+	return trancarBytes(a, ZONA_TRANCAS + dispersao(chave), 1, exclusivo ? F_WRLCK : F_RDLCK) ? -1 : 0;
+}
+
+/**
+\brief Liberta a tranca de uma chave.
+
+@param a Armazém.
+@param chave Chave trancada com @c trancaA .
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+int destrancaA(ARMAZEM a, char *chave)
+{
+	return trancarBytes(a, ZONA_TRANCAS + dispersao(chave), 1, F_UNLCK) ? -1 : 0;
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Devolve o armazém de uma diretória de utilizadores, abrindo-o na primeira utilização.
+O armazém fica aberto até @c fechaArmazem , para que todas as escritas de um pedido sejam
+sincronizadas de uma só vez.
+
+@param path Diretória onde se encontram os users.
+
+@returns O armazém, ou NULL caso não possa ser aberto.
+
+@see ARMAZEM_FICHEIRO
+*/
+ARMAZEM armazem(char *path)
+{
+	char *aux;
+
+	if (principal && strcmp(pathPrincipal, path))
+		fechaArmazem();
+	if (principal == NULL)
+	{
+		aux = malloc(strlen(path) + strlen(ARMAZEM_FICHEIRO) + 1);
+		sprintf(aux, "%s%s", path, ARMAZEM_FICHEIRO);
+		principal = abreA(aux);
+		free(aux);
+		if (principal)
+			pathPrincipal = strdup(path);
+	}
+	return principal;
+}
+
+/**
+\brief Fecha o armazém aberto por @c armazem , libertando as trancas do processo.
+
+@see fechaA
+*/
+void fechaArmazem()
+{
+	if (principal)
+	{
+		fechaA(principal);
+		free(pathPrincipal);
+	}
+	principal = NULL;
+	pathPrincipal = NULL;
+}
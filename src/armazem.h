@@ -0,0 +1,51 @@
+/**
+*@file armazem.h
+\brief Módulo do ARMAZEM, o ficheiro único onde são guardados os utilizadores.
+*/
+#ifndef ARMAZEM_H
+#define ARMAZEM_H
+
+#include <stddef.h>
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Declaração da Estrutura principal.
+*/
+typedef struct armazem* ARMAZEM;
+
+/**
+\brief Nome do ficheiro do armazém, dentro da diretória dos utilizadores.
+*/
+#define ARMAZEM_FICHEIRO "GandaGalo.db"
+
+/**
+\brief Tamanho máximo de uma chave, incluindo o terminador.
+*/
+#define MAX_CHAVE 64
+
+// ------------------------------------------------------------------------------
+
+ARMAZEM abreA (char * ficheiro);
+
+void fechaA (ARMAZEM a);
+
+char * leA (ARMAZEM a, char * chave, size_t * tam);
+
+int leParteA (ARMAZEM a, char * chave, size_t off, char * buf, size_t tam, size_t * total);
+
+int escreveA (ARMAZEM a, char * chave, const char * buf, size_t tam);
+
+int acrescentaA (ARMAZEM a, char * chave, const char * buf, size_t tam);
+
+int apagaA (ARMAZEM a, char * chave);
+
+int trancaA (ARMAZEM a, char * chave, int exclusivo);
+
+int destrancaA (ARMAZEM a, char * chave);
+
+ARMAZEM armazem (char * path);
+
+void fechaArmazem ();
+
+#endif
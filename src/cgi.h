@@ -4,9 +4,12 @@
 /**
 @file cgi.h
 \brief Macros úteis para gerar CGIs
+
+As macros escrevem na @c SAIDA , que é enviada de uma só vez no fim do pedido.
 */
 
 #include <stdio.h>
+#include "saida.h"
 
 /**
 * Caminho para as imagens
@@ -44,9 +47,9 @@
 #define MAP_PATH							"/var/www/html/ficheiro/mapas/"
 
 /**
-\brief Macro para começar o html
+\brief Macro para começar o html. O cabeçalho só é escrito por @c ENVIAR_HTML .
 */
-#define COMECAR_HTML						printf("Content-Type: text/html\n\n<html>\n")
+#define COMECAR_HTML						poeTexto("<html>\n")
 
 
 /**
@@ -55,12 +58,13 @@
 @param tamx O comprimento do svg
 @param tamy A altura do svg
 */
-#define ABRIR_SVG(tamx, tamy)				printf("<svg width=%d height=%d style='text-align:center;'>\n",tamx, tamy)
+#define ABRIR_SVG(tamx, tamy)				(poeTexto("<svg width="), poeInt(tamx), poeTexto(" height="), poeInt(tamy), \
+												poeTexto(" style='text-align:center;'>\n"))
 
 /**
 \brief Macro para fechar um svg
 */
-#define FECHAR_SVG							printf("</svg>\n")
+#define FECHAR_SVG							poeTexto("</svg>\n")
 
 /**
 \brief Macro para criar uma imagem
@@ -70,8 +74,9 @@
 @param ESCALA A escala da imagem
 @param FICHEIRO O caminho para o link do ficheiro
 */
-#define IMAGEM(X, Y, ESCALA, FICHEIRO)		printf("<image x=%d y=%d width=%d height=%d xlink:href=%s%s />\n", \
-												ESCALA * X, ESCALA* Y, ESCALA, ESCALA, IMAGE_PATH, FICHEIRO)
+#define IMAGEM(X, Y, ESCALA, FICHEIRO)		(poeTexto("<image x="), poeInt(ESCALA * X), poeTexto(" y="), poeInt(ESCALA* Y), \
+												poeTexto(" width="), poeInt(ESCALA), poeTexto(" height="), poeInt(ESCALA), \
+												poeTexto(" xlink:href=" IMAGE_PATH), poeTexto(FICHEIRO), poeTexto(" />\n"))
 
 /**
 \brief Macro para criar um quadrado
@@ -81,8 +86,9 @@
 @param ESCALA A escala do quadrado
 @param COR A cor de preenchimento do quadrado
 */
-#define QUADRADO(X, Y, ESCALA, COR)			printf("<rect x=%d y=%d width=%d height=%d fill=%s />\n", \
-												ESCALA * X, ESCALA* Y, ESCALA, ESCALA, COR)
+#define QUADRADO(X, Y, ESCALA, COR)			(poeTexto("<rect x="), poeInt(ESCALA * X), poeTexto(" y="), poeInt(ESCALA* Y), \
+												poeTexto(" width="), poeInt(ESCALA), poeTexto(" height="), poeInt(ESCALA), \
+												poeTexto(" fill="), poeTexto(COR), poeTexto(" />\n"))
 
 /**
 \brief Macro para escrever texto no ecrã
@@ -92,24 +98,39 @@
 @param COR A cor de preenchimento do quadrado
 @param text o texto a escrever
 */
-#define TEXT(X, Y, COR, text)                printf("<text x=%d y=%d fill=%s>%s</text>\n",  \
-                                                X ,Y, COR,text)
+#define TEXT(X, Y, COR, text)                (poeTexto("<text x="), poeInt(X), poeTexto(" y="), poeInt(Y), \
+                                                poeTexto(" fill="), poeTexto(COR), poeTexto(">"), poeTexto(text), \
+                                                poeTexto("</text>\n"))
 
 /**
 \brief Macro para abrir um link
 
 @param link O caminho para o link
 */
-#define ABRIR_LINK(link)					printf("<a xlink:href=%s>\n", link)
+#define ABRIR_LINK(link)					(poeTexto("<a xlink:href="), poeTexto(link), poeTexto(">\n"))
 
 /**
 \brief Macro para fechar o link
 */
-#define FECHAR_LINK							printf("</a>\n")
+#define FECHAR_LINK							poeTexto("</a>\n")
 
 /**
 \brief Macro para fechar o html
 */
-#define FECHAR_HTML							printf("</html>\n")
+#define FECHAR_HTML							poeTexto("</html>\n")
+
+/**
+\brief Macro para enviar a página, com o cabeçalho e o seu tamanho.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+#define ENVIAR_HTML							enviaSaida("text/html")
+
+/**
+\brief Macro para enviar uma resposta JSON, escrita na @c SAIDA em vez da página.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+#define ENVIAR_JSON							enviaSaida("application/json")
 
 #endif
@@ -0,0 +1,65 @@
+/**
+@file compilar.c
+\brief Ficheiro do compilador de mapas prédefinidos.
+
+Valida e resolve uma só vez os mapas de um ficheiro de mapas, e guarda-os num pacote,
+ao lado deste, que é depois usado pelo @c CATALOGO sem ler o texto dos mapas.
+Guarda também os metadados de cada mapa, com a dificuldade e a miniatura já desenhada.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "filemanager.h"
+#include "frontendTab.h"
+#include "saida.h"
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Desenha a miniatura de um mapa, tirando da @c SAIDA o que @c drawTab escreve.
+
+@param e Mapa a desenhar.
+@param tam Endereço onde é colocado o tamanho do desenho.
+
+@returns O fragmento SVG, que deve ser libertado com @c free .
+*/
+static char *miniatura(ESTADO e, size_t *tam)
+{
+    const char *s;
+    char *svg;
+
+    limpaSaida();
+    setE_menu(e, SELECT_MAP);
+    drawTab(e, MINIATURA, 0, 0);
+
+    s = conteudoSaida(tam);
+    svg = malloc(*tam + 1);
+    memcpy(svg, s, *tam);
+    limpaSaida();
+    return svg;
+}
+
+/**
+\brief Função main para compilar mapas prédefinidos.
+
+Recebe o caminho do ficheiro de mapas, sendo usado @c FILE_PATH caso não seja dado.
+*/
+int main(int argc, char *argv[])
+{
+    char *path = (argc > 1) ? argv[1] : FILE_PATH;
+    int n;
+
+    //as definições das peças são postas pela página, não por cada miniatura
+    defsTab();
+    limpaSaida();
+    n = compilaCatalogo(path, stdout, miniatura);
+
+    if (n < 0)
+    {
+        perror(" Não foi possível compilar os mapas.");
+        return 1;
+    }
+    printf("%d mapas compilados em %s%s\n", n, path, PACOTE_EXT);
+    return 0;
+}
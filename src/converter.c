@@ -0,0 +1,103 @@
+/**
+@file converter.c
+\brief Ficheiro do conversor dos ficheiros de utilizador antigos para o @c ARMAZEM .
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "cgi.h"
+#include "estado.h"
+#include "userfiles.h"
+#include "leaderboard.h"
+#include "armazem.h"
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Passa um utilizador para o armazém, a partir do seu ficheiro de texto.
+
+@param user Nome do utilizador, sem extensão.
+
+@returns 1 se o utilizador foi convertido, 0 caso contrário.
+*/
+static int converte(char *user)
+{
+	int flag;
+	ESTADO e = bin2estado_un(USER_PATH, user, &flag);
+	if (flag)
+		estado2bin_un(USER_PATH, user, e);
+	destroyState(e);
+	printf("%s: %s\n", user, flag ? "convertido" : "inválido");
+	return flag;
+}
+
+/**
+\brief Indica se um utilizador já está no armazém.
+
+@param user Nome do utilizador, sem extensão.
+
+@returns 1 se o utilizador está no armazém, 0 caso contrário.
+*/
+static int noArmazem(char *user)
+{
+	ARMAZEM a = armazem(USER_PATH);
+	char chave[MAX_CHAVE], *v = NULL;
+	size_t tam;
+
+	if (a && strlen(user) + 4 < MAX_CHAVE)
+	{
+		sprintf(chave, "%s.sav", user);
+		v = leA(a, chave, &tam);
+		free(v);
+	}
+	return v != NULL;
+}
+
+/**
+\brief Função main para passar os ficheiros de utilizador para o armazém.
+
+Sem argumentos são convertidos os ficheiros @b .txt de @c USER_PATH dos utilizadores que
+ainda não estão no armazém, tal como a leaderboard guardada em @b users.save . Caso
+contrário são convertidos os utilizadores passados como argumento.
+*/
+int main(int argc, char *argv[])
+{
+	int k, n = 0, r = 0;
+	char *ext;
+	DIR *d;
+	struct dirent *f;
+
+	if (argc > 1)
+		for (k = 1; k < argc; k++, n++)
+			r += converte(argv[k]);
+	else if ((d = opendir(USER_PATH)) != NULL)
+	{
+		while ((f = readdir(d)) != NULL)
+		{
+			if ((ext = strstr(f->d_name, ".txt")) == NULL || ext[4] != '\0')
+				continue;
+			*ext = '\0';
+			if (!noArmazem(f->d_name))
+			{
+				r += converte(f->d_name);
+				n++;
+			}
+		}
+		closedir(d);
+		if ((k = importa_info(USER_PATH "users.save")) >= 0)
+			printf("leaderboard: %d utilizadores\n", k);
+	}
+	else
+	{
+		perror(USER_PATH);
+		return 1;
+	}
+
+	fechaArmazem();
+	printf("%d de %d utilizadores convertidos.\n", r, n);
+	return (r != n);
+}
@@ -106,7 +106,8 @@ char advance (char num, int n, char mode)
 void playPos(ESTADO e, int i, int j){
     int n = formove(e,i,j);
     char val = getE_elem(e,i,j);
-	push(getE_stack(e,0),i,j,val);
-	setE_elem(e,i,j,advance(val,n,getE_menu(e)));
+    char novo = advance(val,n,getE_menu(e));
+	jogada(getE_hist(e),i,j,val,novo);
+	setE_elem(e,i,j,novo);
 }
 
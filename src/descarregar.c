@@ -0,0 +1,27 @@
+/**
+@file descarregar.c
+\brief Ficheiro do programa que escreve no @c ARMAZEM as sessões alteradas.
+
+As sessões só são escritas no armazém no fim de um pedido, pelo que as últimas jogadas de um
+utilizador que deixe de jogar ficam só em memória. Este programa deve ser corrido periodicamente,
+pelo cron, e antes de a máquina ser desligada.
+*/
+
+#include <stdio.h>
+#include "cgi.h"
+#include "userfiles.h"
+#include "armazem.h"
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Função main para escrever no armazém todas as sessões alteradas.
+
+Uso: @b descarregar
+*/
+int main(void)
+{
+	varreSessoes_un(USER_PATH, 0);
+	fechaArmazem();
+	return 0;
+}
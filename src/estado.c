@@ -16,10 +16,18 @@
 
 // ------------------------------------------------------------------------------
 
+/**
+\brief Linha da grelha partilhável entre estados.
+*/
+typedef struct pagina * PAGINA;
+
+// ------------------------------------------------------------------------------
+
 /* Metódos públicos */
 
 /* Funções primárias */
 ESTADO makeState(ESTADO e);
+ESTADO snapshotState (ESTADO e);
 void destroyState (ESTADO e);
 ESTADO inicializar (char * user, int ln, int col);
 long n_solutions (ESTADO e);
@@ -32,26 +40,50 @@ void setE_cols (ESTADO e, int cols);
 void setE_menu (ESTADO e, int menu);
 void setE_elem (ESTADO e, int i, int j, char val);
 void setE_elemT (ESTADO e, int i, int j, char (*map) (char));
-void setE_stack (ESTADO e, STACK s, int c);
+void setE_hist (ESTADO e, HISTORIA h);
 void setE_flag (ESTADO e, int flag);
 void setE_transverse (ESTADO e, int li, int ci, char (*map) (char));
 void setE_base (ESTADO e, char (*map) (char));
 void setE_help (ESTADO e, int help);
 void setE_helpB (ESTADO e);
+void setE_pagina (ESTADO e, int pagina);
+void setE_janela (ESTADO e, int janela);
+void setE_mapa (ESTADO e, int mapa);
 
 /* Getters */
 char * getE_user (ESTADO e);
 int getE_cols (ESTADO e);
 int getE_lins (ESTADO e);
 int getE_menu (ESTADO e);
-STACK getE_stack (ESTADO e, int c);
+HISTORIA getE_hist (ESTADO e);
 int getE_flag (ESTADO e);
 char getE_elem(ESTADO e, int i, int j);
 int getE_help (ESTADO e);
 int getE_verf (ESTADO e, int (*inclusivecase) (ESTADO,int,int));
+int getE_vazias (ESTADO e);
+int getE_conflitos (ESTADO e);
+int getE_pagina (ESTADO e);
+int getE_janela (ESTADO e);
+int getE_mapa (ESTADO e);
+
+/* Metódos privados */
+static void largarPagina (PAGINA p);
+static char * escreverLinha (ESTADO e, int i);
+static int classe (char val);
+static int trio (ESTADO e, int i, int j, int di, int dj);
+static void contaPeca (ESTADO e, int i, int j, int sinal);
+static void recontar (ESTADO e);
 
 // ------------------------------------------------------------------------------
 
+/**
+\brief Linha da grelha, partilhada entre estados até que um deles a altere.
+*/
+typedef struct pagina {
+	int refs;                        /**< Número de estados que partilham a linha */
+	char pecas[MAX_GRID];            /**< Peças da linha */
+} * PAGINA;
+
 /**
 \brief Estrutura que armazena o estado do jogo.
 */
@@ -63,45 +95,237 @@ typedef struct estado {
 	int menu;                        /**< Menu atual */
 	int help;                        /**< Número restante de hints */
 	int wins;						 /**< Número de vitórias*/
-	char grelha[MAX_GRID][MAX_GRID]; 				/**< Grelha do jogo */
-	STACK passado;                   /**< Stack para undo */
-	STACK futuro;                    /**< Stack para redo */
+	int vazias;                      /**< Número de peças vazias na grelha */
+	int conflitos;                   /**< Número de trios de peças iguais em linha */
+	int pagina;                      /**< Página da leaderboard, ou dos mapas, a desenhar, que não é guardada */
+	int janela;                      /**< Janela de tempo da leaderboard a desenhar, que não é guardada */
+	int mapa;                        /**< ID do mapa prédefinido carregado no pedido, 0 se nenhum, que não é guardado */
+	PAGINA grelha[MAX_GRID];         /**< Linhas da grelha do jogo, NULL se nunca escritas */
+	HISTORIA hist;                   /**< Árvore de jogadas para undo e redo */
 } * ESTADO;
 
 // ------------------------------------------------------------------------------
 
+/**
+\brief Direções das linhas de três peças verificadas na grelha.
+*/
+static const int direcoes[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+
+/**
+\brief Macro que verifica se uma posição se encontra dentro da grelha do estado.
+
+@param e Estado a verificar.
+@param i Linha da posição.
+@param j Coluna da posição.
+*/
+#define dentro(e, i, j) ((i) >= 0 && (j) >= 0 && (i) < (e)->num_lins && (j) < (e)->num_cols)
+
+/**
+\brief Macro que obtem uma peça da grelha. Linhas nunca escritas são lidas como @c BLOQUEADA .
+
+@param e Estado a consultar.
+@param i Linha da peça.
+@param j Coluna da peça.
+*/
+#define peca(e, i, j) ((e)->grelha[i] ? (e)->grelha[i]->pecas[j] : BLOQUEADA)
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Liberta uma referência para uma linha, destruindo-a se for a última.
+
+@param p Linha a libertar.
+*/
+static void largarPagina (PAGINA p)
+{
+	if (p && --p->refs == 0)
+		free(p);
+}
+
+/**
+\brief Obtem uma linha da grelha que possa ser alterada sem afetar outros estados.
+
+Se a linha for partilhada é feita uma cópia privada, se nunca tiver sido escrita é criada.
+
+@param e Estado a alterar.
+@param i Linha pretendida.
+
+@returns As peças da linha.
+*/
+static char * escreverLinha (ESTADO e, int i)
+{
+	PAGINA p = e->grelha[i];
+	if (p == NULL){
+		p = calloc(1, sizeof(struct pagina));
+		p->refs = 1;
+		e->grelha[i] = p;
+	}
+	else if (p->refs > 1){
+		p = malloc(sizeof(struct pagina));
+		*p = *(e->grelha[i]);
+		p->refs = 1;
+		largarPagina(e->grelha[i]);
+		e->grelha[i] = p;
+	}
+	return p->pecas;
+}
+
+/**
+\brief Função que indica a que classe pertence uma peça.
+
+Peças fixas e soltas do mesmo símbolo pertencem à mesma classe.
+
+@param val Peça a classificar.
+
+@returns 1 para X, 2 para O, 0 para peças vazias ou bloqueadas.
+*/
+static int classe (char val)
+{
+	int r = 0;
+	if (val == FIXO_X || val == SOL_X)
+		r = 1;
+	else if (val == FIXO_O || val == SOL_O)
+		r = 2;
+	return r;
+}
+
+/**
+\brief Verifica se as três peças que começam numa posição, segundo uma direção, são iguais.
+
+@param e Estado a verificar.
+@param i Linha da primeira peça.
+@param j Coluna da primeira peça.
+@param di Componente das linhas da direção.
+@param dj Componente das colunas da direção.
+
+@returns 1 se as três peças estiverem na grelha e forem iguais, 0 caso contrário.
+
+@see classe
+*/
+static int trio (ESTADO e, int i, int j, int di, int dj)
+{
+	int c;
+	if (!dentro(e, i, j) || !dentro(e, i + 2*di, j + 2*dj))
+		return 0;
+	c = classe(peca(e, i, j));
+	return (c != 0 && c == classe(peca(e, i + di, j + dj))
+	               && c == classe(peca(e, i + 2*di, j + 2*dj)));
+}
+
+/**
+\brief Soma aos contadores do estado a contribuição de uma peça.
+
+São considerados todos os trios que contêm a posição, pelo que o custo é constante.
+
+@param e Estado a alterar.
+@param i Linha da peça.
+@param j Coluna da peça.
+@param sinal 1 para adicionar a contribuição, -1 para a retirar.
+
+@see trio
+*/
+static void contaPeca (ESTADO e, int i, int j, int sinal)
+{
+	int d, k, di, dj;
+	if (peca(e, i, j) == VAZIA)
+		e->vazias += sinal;
+	for (d = 0; d < 4; d++){
+		di = direcoes[d][0]; dj = direcoes[d][1];
+		for (k = 0; k < 3; k++)
+			e->conflitos += sinal * trio(e, i - k*di, j - k*dj, di, dj);
+	}
+}
+
+/**
+\brief Recalcula os contadores do estado percorrendo toda a grelha.
+
+Só é necessário quando as dimensões da grelha mudam.
+
+@param e Estado a recalcular.
+
+@see trio
+*/
+static void recontar (ESTADO e)
+{
+	int i, j, d;
+	e->vazias = 0;
+	e->conflitos = 0;
+	for (i = 0; i < e->num_lins; i++)
+		for (j = 0; j < e->num_cols; j++){
+			if (peca(e, i, j) == VAZIA)
+				e->vazias++;
+			for (d = 0; d < 4; d++)
+				e->conflitos += trio(e, i, j, direcoes[d][0], direcoes[d][1]);
+		}
+}
+
+// ------------------------------------------------------------------------------
+
 /**
 \brief Função que cria um estado.
 
 @param e Estado a copiar.
 
-@returns Caso 'e' não seja NULL devolve um pointer para uma cópia de 'e', caso contrário devolve um pointer para um estado indefinido
+@returns Caso 'e' não seja NULL devolve um pointer para uma cópia de 'e', caso contrário devolve um pointer para um estado vazio, com a @c HISTORIA inicializada.
 
-@see setE_state
+@see snapshotState
 */
 ESTADO makeState(ESTADO e)
 {	
-	ESTADO new = malloc(sizeof(struct estado));
-	new->passado = NULL;
-	new->futuro = NULL;
+	ESTADO new;
 	if (e != NULL)
-		setE_state(new,e);
+		return snapshotState(e);
+	new = calloc(1, sizeof(struct estado));
+	new->hist = initH();
+	return new;
+}
+
+/**
+\brief Função que cria uma cópia de um estado para cálculos temporários.
+
+A cópia partilha as linhas da grelha com @p e , que só são copiadas quando uma das partes as altera,
+pelo que criar a cópia não copia a grelha. A cópia não possui histórico, a sua @c HISTORIA é NULL.
+
+@param e Estado a copiar.
+
+@returns A cópia, que deve ser destruida com @c destroyState .
+
+@see escreverLinha
+*/
+ESTADO snapshotState (ESTADO e)
+{
+	int i;
+	ESTADO new = malloc(sizeof(struct estado));
+	*new = *e;
+	for (i = 0; i < MAX_GRID; i++)
+		if (new->grelha[i])
+			new->grelha[i]->refs++;
+	new->hist = NULL;
 	return new;
 }
 
 /**
 \brief Função que destroi o estado.
 
+São libertadas as linhas da grelha que mais nenhum estado partilha e a @c HISTORIA do estado.
+
 @param e Estado a destruir.
 */
 void destroyState (ESTADO e)
 {
+	int i;
+	for (i = 0; i < MAX_GRID; i++)
+		largarPagina(e->grelha[i]);
+	if (e->hist)
+		destroyH(e->hist);
 	free(e);
 }
 
 /**
 \brief Função que inicializa o estado.
 
+O novo utilizador é registado na leaderboard, com 0 vitórias.
+
 @param user Uma string com o nome de utilizador do novo estado.
 @param ln Número de linhas no mapa.
 @param col Número de colunas no mapa.
@@ -115,6 +339,7 @@ void destroyState (ESTADO e)
 @see setE_user
 @see setE_wins
 @see setE_menu
+@see push_info
 */
 ESTADO inicializar(char * user, int ln, int col) {
 	ESTADO e = makeState(NULL);
@@ -124,6 +349,7 @@ ESTADO inicializar(char * user, int ln, int col) {
 	setE_flag(e,0);
 	setE_user(e,user);
 	setE_wins(e,0);
+	push_info(user,0);
 	setE_menu(e,SELECT_MENU);
 	return e;
 }
@@ -135,13 +361,14 @@ ESTADO inicializar(char * user, int ln, int col) {
 
 @returns Número de soluções.
 
+@see snapshotState
 @see makefixo
 @see solve
 */
 long n_solutions (ESTADO e)
 {
 	long m;
-	ESTADO tmp = makeState(e);
+	ESTADO tmp = snapshotState(e);
 	makefixo(tmp);
 	solve(tmp,&m);
 	destroyState(tmp);
@@ -151,16 +378,25 @@ long n_solutions (ESTADO e)
 /**
 \brief Função que copia um estado para outro.
 
+A grelha passa a ser partilhada pelos dois estados. A @c HISTORIA de @p sourc passa para @p dest ,
+ficando @p sourc sem histórico.
+
 @param dest Para onde é copiado.
 @param sourc De onde é copidado.
 */
 void setE_state (ESTADO dest, ESTADO sourc)
 {
-	int i, j;
+	int i;
+	HISTORIA hist = dest->hist;
+	for (i = 0; i < MAX_GRID; i++){
+		if (sourc->grelha[i])
+			sourc->grelha[i]->refs++;
+		largarPagina(dest->grelha[i]);
+	}
 	*dest = *sourc;
-	for (i = 0 ; i < sourc->num_lins; i++)
-		for (j = 0; j < sourc->num_cols; j++)
-			dest->grelha[i][j] = sourc->grelha[i][j];
+	dest->hist = hist;
+	setE_hist(dest,sourc->hist);
+	sourc->hist = NULL;
 }
 
 /**
@@ -179,27 +415,39 @@ void setE_user (ESTADO e, char * user)
 /**
 \brief Função que altera o número de linhas.
 
+Os contadores só são recalculados caso o número de linhas mude.
+
 @param e Estado a alterar.
 @param lins Novo número de linhas.
 
 @see estado::num_lins
+@see recontar
 */
 void setE_lins (ESTADO e, int lins)
 {
-	e->num_lins = lins;
+	if (e->num_lins != lins){
+		e->num_lins = lins;
+		recontar(e);
+	}
 }
 
 /**
 \brief Função que altera o número de colunas.
 
+Os contadores só são recalculados caso o número de colunas mude.
+
 @param e Estado a alterar.
 @param cols Novo número de colunas.
 
 @see estado::num_cols
+@see recontar
 */
 void setE_cols (ESTADO e, int cols)
 {
-	e->num_cols = cols;
+	if (e->num_cols != cols){
+		e->num_cols = cols;
+		recontar(e);
+	}
 }
 
 /**
@@ -218,14 +466,28 @@ void setE_menu (ESTADO e, int menu)
 /**
 \brief Função que altera um elemento do tabuleiro.
 
+Os contadores de peças vazias e de trios inválidos são atualizados considerando apenas os trios que contêm a posição.
+Se a peça não mudar a linha não é copiada.
+
 @param e Estado a alterar.
 @param i Linha a alterar.
 @param j Coluna a alterar.
 @param val A colocar.
+
+@see contaPeca
+@see escreverLinha
 */
 void setE_elem (ESTADO e, int i, int j, char val)
 {
-	e->grelha[i][j] = val;
+	if (i < 0 || j < 0 || i >= MAX_GRID || j >= MAX_GRID || peca(e, i, j) == val)
+		return;
+	if (dentro(e, i, j)){
+		contaPeca(e, i, j, -1);
+		escreverLinha(e, i)[j] = val;
+		contaPeca(e, i, j, 1);
+	}
+	else
+		escreverLinha(e, i)[j] = val;
 }
 
 /**
@@ -240,7 +502,7 @@ void setE_elem (ESTADO e, int i, int j, char val)
 */
 void setE_elemT (ESTADO e, int i, int j, char (*map) (char))
 {
-	char val = e->grelha[i][j];
+	char val = getE_elem(e,i,j);
 	if (map == NULL)
 		setE_elem(e,i,j,VAZIA);
 	else 
@@ -248,22 +510,21 @@ void setE_elemT (ESTADO e, int i, int j, char (*map) (char))
 }
 
 /**
-\brief Função que altera as stack no estado.
+\brief Função que altera a história de jogadas no estado.
+
+A @c HISTORIA substituida é destruida, passando o estado a ser dono de @p h .
 
 @param e @c ESTADO a alterar.
-@param s @c STACK a colocar.
-@param c Indicador da @c STACK a alterar. Se for 0 a @c STACK alterada será a passado, caso contrário será a futuro.
+@param h @c HISTORIA a colocar.
 
-@see STACK
-@see estado::passado
-@see estado::futuro
+@see HISTORIA
+@see estado::hist
 */
-void setE_stack (ESTADO e, STACK s, int c)
+void setE_hist (ESTADO e, HISTORIA h)
 {
-	if (c == 0)
-		e->passado = s;
-	else
-		e->futuro = s;
+	if (e->hist && e->hist != h)
+		destroyH(e->hist);
+	e->hist = h;
 }
 
 /**
@@ -309,27 +570,24 @@ void setE_transverse (ESTADO e, int li, int ci, char (*map) (char))
 
 A base colocada em @p e corresponde a:
 	- Reajustar o número de ajudas para @c MAX_HELP.
-	- Inicializar a @c STACK @c passado'.
-	- Inicializar a @c STACK @c futuro'.
+	- Inicializar a @c HISTORIA de jogadas.
 	- Aplicar uma função de mapping a todos os elementos da grelha.
 
 @param e @c ESTADO onde irá ser colocada a base.
 @param map Função de mapping.
 
 @see MAX_HELP
-@see STACK
+@see HISTORIA
 @see setE_help
-@see estado::passado
-@see estado::futuro
-@see setE_stack
-@see initS()
+@see estado::hist
+@see setE_hist
+@see initH()
 @see setE_transverse
 */
 void setE_base (ESTADO e, char (*map) (char))
 {
 	setE_helpB(e);
-	setE_stack(e,initS(),0);
-	setE_stack(e,initS(),1);
+	setE_hist(e,initH());
 	setE_transverse(e,0,0,map);
 }
 
@@ -357,19 +615,60 @@ void setE_helpB (ESTADO e)
 }
 
 /**
-\brief Função que coloca o número de vitórias no @c ESTADO e no ficheiro para tal.
+\brief Função que coloca o número de vitórias no @c ESTADO .
+
+A leaderboard não é alterada, pelo que carregar um estado não escreve na leaderboard.
+As vitórias só são passadas para a leaderboard quando mudam, em @c victory .
 
 @param e @c ESTADO que irá ser alterado.
 @param wins Número de vitórias novo.
 
-@see push_info
+@see victory
 */
 void setE_wins (ESTADO e, int wins)
 {
-	push_info(e->user,wins);
 	e->wins = wins;
 }
 
+/**
+\brief Função que altera a página da leaderboard, ou dos mapas, a desenhar.
+
+@param e @c ESTADO que irá ser alterado.
+@param pagina Página, a partir de 0.
+
+@see estado::pagina
+*/
+void setE_pagina (ESTADO e, int pagina)
+{
+	e->pagina = pagina;
+}
+
+/**
+\brief Função que altera a janela de tempo da leaderboard a desenhar.
+
+@param e @c ESTADO que irá ser alterado.
+@param janela @c JANELA de tempo.
+
+@see estado::janela
+*/
+void setE_janela (ESTADO e, int janela)
+{
+	e->janela = janela;
+}
+
+/**
+\brief Função que altera o mapa prédefinido carregado no pedido.
+
+@param e @c ESTADO que irá ser alterado.
+@param mapa ID do mapa, 0 se nenhum.
+
+@see estado::mapa
+*/
+void setE_mapa (ESTADO e, int mapa)
+{
+	e->mapa = mapa;
+}
+
 /**
 \brief Função que devolve o nome de utilizador.
 
@@ -427,23 +726,18 @@ int getE_cols (ESTADO e)
 }
 
 /**
-\brief Função que devolve uma @c STACK do @c ESTADO.
+\brief Função que devolve a história de jogadas do @c ESTADO.
 
 @param e @c ESTADO a procurar.
-@param c Indicador da @c STACK a devolver. Se for 0 a @c STACK alterada será a passado, caso contrário será a futuro.
 
-@returns Uma @c STACK. Se @p c for 0 devolve a @c STACK do @b undo, caso contrário devolve a @c STACK do @b redo.
+@returns A @c HISTORIA usada para @b undo e @b redo, NULL se o estado for uma cópia temporária.
 
-@see STACK
-@see estado::passado
-@see estado::futuro
+@see HISTORIA
+@see estado::hist
 */	
-STACK getE_stack (ESTADO e, int c)
+HISTORIA getE_hist (ESTADO e)
 {
-	if (c == 0)
-		return (e->passado);
-	else
-		return (e->futuro);
+	return (e->hist);
 }
 
 /**
@@ -471,7 +765,7 @@ int getE_flag (ESTADO e)
 */	
 char getE_elem (ESTADO e, int i, int j)
 {
-	return (e->grelha[i][j]);
+	return (peca(e, i, j));
 }
 
 /**
@@ -520,4 +814,74 @@ int getE_verf (ESTADO e, int (*inclusivecase) (ESTADO,int,int))
 int getE_wins (ESTADO e)
 {
 	return (e->wins);
+}
+
+/**
+\brief Função que obtem o número de peças vazias na grelha.
+
+@param e @c ESTADO a procurar.
+
+@returns Número de peças vazias.
+
+@see estado::vazias
+*/
+int getE_vazias (ESTADO e)
+{
+	return (e->vazias);
+}
+
+/**
+\brief Função que obtem a página da leaderboard, ou dos mapas, a desenhar.
+
+@param e @c ESTADO a procurar.
+
+@returns A página, a partir de 0.
+
+@see estado::pagina
+*/
+int getE_pagina (ESTADO e)
+{
+	return (e->pagina);
+}
+
+/**
+\brief Função que obtem a janela de tempo da leaderboard a desenhar.
+
+@param e @c ESTADO a procurar.
+
+@returns A @c JANELA de tempo.
+
+@see estado::janela
+*/
+int getE_janela (ESTADO e)
+{
+	return (e->janela);
+}
+
+/**
+\brief Função que obtem o mapa prédefinido carregado no pedido.
+
+@param e @c ESTADO a procurar.
+
+@returns O ID do mapa, 0 se nenhum.
+
+@see estado::mapa
+*/
+int getE_mapa (ESTADO e)
+{
+	return (e->mapa);
+}
+
+/**
+\brief Função que obtem o número de trios de peças iguais em linha na grelha.
+
+@param e @c ESTADO a procurar.
+
+@returns Número de trios inválidos, 0 se o tabuleiro for válido.
+
+@see estado::conflitos
+*/
+int getE_conflitos (ESTADO e)
+{
+	return (e->conflitos);
 }
\ No newline at end of file
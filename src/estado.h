@@ -6,7 +6,7 @@
 #ifndef ___ESTADO_H___
 #define ___ESTADO_H___
 
-#include "stack.h"
+#include "historia.h"
 
 // ------------------------------------------------------------------------------
 
@@ -71,6 +71,7 @@ typedef struct estado * ESTADO;
 
 /* Funções elementares */
 ESTADO makeState(ESTADO e);
+ESTADO snapshotState (ESTADO e);
 void destroyState (ESTADO e);
 ESTADO inicializar(char * user, int ln, int col);
 long n_solutions (ESTADO e);
@@ -83,24 +84,36 @@ void setE_cols (ESTADO e, int cols);
 void setE_menu (ESTADO e, int menu);
 void setE_elem (ESTADO e, int i, int j, char val);
 void setE_elemT (ESTADO e, int i, int j, char (*map) (char));
-void setE_stack (ESTADO e, STACK s, int c);
+void setE_hist (ESTADO e, HISTORIA h);
 void setE_flag (ESTADO e, int flag);
 void setE_transverse (ESTADO e, int li, int ci, char (*map) (char));
 void setE_base (ESTADO e, char (*map) (char));
 void setE_help (ESTADO e, int help);
 void setE_helpB (ESTADO e);
 void setE_wins (ESTADO e, int wins);
+void setE_pagina (ESTADO e, int pagina);
+
+void setE_janela (ESTADO e, int janela);
+
+void setE_mapa (ESTADO e, int mapa);
 
 /* Getters */
 char * getE_user (ESTADO e);
 int getE_cols (ESTADO e);
 int getE_lins (ESTADO e);
 int getE_menu (ESTADO e);
-STACK getE_stack (ESTADO e, int c);
+HISTORIA getE_hist (ESTADO e);
 int getE_flag (ESTADO e);
 char getE_elem(ESTADO e, int i, int j);
 int getE_help (ESTADO e);
 int getE_verf (ESTADO e, int (*inclusivecase) (ESTADO,int,int));
 int getE_wins (ESTADO e);
+int getE_pagina (ESTADO e);
+
+int getE_janela (ESTADO e);
+
+int getE_mapa (ESTADO e);
+int getE_vazias (ESTADO e);
+int getE_conflitos (ESTADO e);
 
 #endif
\ No newline at end of file
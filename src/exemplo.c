@@ -15,11 +15,12 @@ int main()
 	BODY;
 	DIV_CENTRAR;
 
-	pipe_env();
+	if (pipe_env())
+		return ENVIAR_JSON ? 1 : 0;
 
 	FECHAR_DIV;
 	FECHAR_BODY;
 	FECHAR_HTML;
 
-	return 0;
+	return ENVIAR_HTML ? 1 : 0;
 }
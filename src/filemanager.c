@@ -1,10 +1,28 @@
 /**
 @file filemanager.c
 \brief Módulo de leitura de ficheiros.
+
+Os mapas prédefinidos são lidos através de um @c CATALOGO , um índice guardado ao lado do
+ficheiro de mapas, com a posição e as dimensões de cada mapa ordenadas por ID. O índice é
+criado na primeira utilização, e sempre que o ficheiro de mapas muda, pelo que ler um mapa
+custa uma pesquisa binária no índice mapeado em memória e uma leitura do ficheiro de mapas.
+
+Caso exista um pacote compilado com @c compilaCatalogo , e este corresponda ao ficheiro de mapas,
+o catálogo usa-o em vez do índice: o pacote tem o mesmo cabeçalho e entradas, já com a validade
+e o número de soluções de cada mapa, seguidos das grelhas, que são copiadas sem serem lidas.
+Ao lado do pacote são guardados os metadados de cada mapa, a dificuldade e a miniatura já
+desenhada, que só são mapeados em memória quando são pedidos.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include "solver.h"
 #include "filemanager.h"
 #include "estado.h"
@@ -16,12 +34,123 @@
 
 /* Métodos públicos */
 ESTADO select_arcade(char *path, int id);
+CATALOGO abreCatalogo(char *path);
+void fechaCatalogo(CATALOGO c);
+int nMapas(CATALOGO c);
+int idMapa(CATALOGO c, int k);
+ESTADO leMapa(CATALOGO c, int id);
+int validoMapa(CATALOGO c, int id);
+long solucoesMapa(CATALOGO c, int id);
+int dificuldadeMapa(CATALOGO c, int id);
+const char *miniaturaMapa(CATALOGO c, int id, size_t *tam);
+int compilaCatalogo(char *path, FILE *log, DESENHO desenha);
 ESTADO select_padrao(char *path, char *map, int *flag);
 ESTADO select_random(int id, int * flag);
 
+// ------------------------------------------------------------------------------
+
+/**
+\brief Identificador no início do índice de um @c CATALOGO .
+*/
+#define CATALOGO_MAGIC "GGMC"
+
+/**
+\brief Versão do formato do índice de um @c CATALOGO .
+*/
+#define CATALOGO_VERSAO 2
+
+/**
+\brief Identificador no início do pacote compilado de um @c CATALOGO .
+*/
+#define PACOTE_MAGIC "GGPK"
+
+/**
+\brief Identificador no início dos metadados de um @c CATALOGO .
+*/
+#define META_MAGIC "GGMD"
+
+/**
+\brief Entrada do índice, ou do pacote, de um @c CATALOGO , com a localização de um mapa.
+
+No pacote, em @c off está a grelha, com uma peça por byte, seguida de uma solução, com um bit
+por peça, a 1 para X. No índice, a validade e o número de soluções não são conhecidos.
+*/
+typedef struct entrada
+{
+	int32_t id;        /**< ID do mapa */
+	int32_t lins;      /**< Número de linhas do mapa, 0 se as dimensões forem inválidas */
+	int32_t cols;      /**< Número de colunas do mapa */
+	int32_t valido;    /**< 1 se o mapa for válido, 0 se não for, -1 se não for conhecido */
+	int64_t nsol;      /**< Número de soluções do mapa, -1 se não for conhecido */
+	int64_t off;       /**< Posição da grelha no ficheiro de mapas, ou no pacote */
+} ENTRADA;
+
+/**
+\brief Cabeçalho do índice, ou do pacote, de um @c CATALOGO , seguido de @c n entradas ordenadas por ID.
+
+O tamanho e a data de alteração do ficheiro de mapas indicam se o índice ainda lhe corresponde.
+*/
+typedef struct cabecalho
+{
+	char magic[4];     /**< CATALOGO_MAGIC ou PACOTE_MAGIC */
+	int32_t versao;    /**< CATALOGO_VERSAO */
+	int32_t n;         /**< Número de mapas */
+	int32_t reservado; /**< Não usado */
+	int64_t tam;       /**< Tamanho do ficheiro de mapas */
+	int64_t mtime;     /**< Data de alteração do ficheiro de mapas */
+} CABECALHO;
+
+/**
+\brief Metadados de um mapa, pela mesma ordem das entradas do pacote.
+
+Os metadados seguem-se a um @c CABECALHO com @c META_MAGIC , e são seguidos das miniaturas.
+*/
+typedef struct metadados
+{
+	int32_t id;          /**< ID do mapa */
+	int32_t dificuldade; /**< Dificuldade, de 1 a 5, ou 0 se o mapa não tiver solução */
+	int64_t off;         /**< Posição da miniatura no ficheiro dos metadados */
+	int64_t tam;         /**< Tamanho da miniatura */
+} METADADOS;
+
+/**
+\brief Catálogo dos mapas prédefinidos, com o ficheiro de mapas aberto.
+*/
+struct catalogo
+{
+	FILE *file;        /**< Ficheiro de mapas */
+	char *path;        /**< Caminho do ficheiro de mapas */
+	struct stat st;    /**< Informação do ficheiro de mapas */
+	ENTRADA *v;        /**< Entradas do índice, ordenadas por ID */
+	int n;             /**< Número de entradas */
+	void *mapa;        /**< Índice, ou pacote, mapeado em memória, ou NULL se @c v foi alocado */
+	size_t tamMapa;    /**< Tamanho do índice mapeado */
+	int pacote;        /**< Diferente de 0 se @c mapa for um pacote */
+	void *meta;        /**< Metadados mapeados em memória, ou NULL */
+	size_t tamMeta;    /**< Tamanho dos metadados mapeados */
+	int metaAberto;    /**< Diferente de 0 se já se tentou abrir os metadados */
+};
+
+/**
+\brief Número de bytes de um mapa no pacote, com a grelha e a solução.
+*/
+#define TAM_PACOTE(x) ((size_t)(x)->lins * (x)->cols + ((size_t)(x)->lins * (x)->cols + 7) / 8)
+
 /* Métodos privados */
 static ESTADO ler_puzzle_padrao(FILE *file, int *flag);
+static ESTADO ler_mapa(FILE *file, ENTRADA *x, int *completo);
+static ESTADO ler_pacote(CATALOGO c, ENTRADA *x);
 static char convertFl(char ch, int *flag);
+static CATALOGO abreTexto(char *path, struct stat *st);
+static int abreIndice(CATALOGO c, char *idx, struct stat *st, const char *magic);
+static void constroiIndice(CATALOGO c);
+static void cabecalho(CABECALHO *cab, const char *magic, int n, struct stat *st);
+static int guarda(char *nome, CABECALHO *cab, const void *v, size_t tamEntrada, const char *dados, size_t tam);
+static char *sidecar(char *path, const char *ext);
+static METADADOS *metaMapa(CATALOGO c, ENTRADA *x);
+static int dificuldade(const char *g, int n, long nsol);
+static int cmpEntrada(const void *a, const void *b);
+static ENTRADA *procuraMapa(CATALOGO c, int id);
 
 // ------------------------------------------------------------------------------
 
@@ -40,7 +169,7 @@ static ESTADO ler_puzzle_padrao(FILE *file, int *flag)
 	int lLidas = 0, cLidas, ch = 0;
 
 	ch = fscanf(file, "%d %d\n", &n_lin, &n_col);
-	if (ch != 2)
+	if (ch != 2 || n_lin <= 0 || n_lin > MAX_GRID || n_col <= 0 || n_col > MAX_GRID)
 	{
 		*flag = 0;
 		return e;
@@ -62,6 +191,8 @@ static ESTADO ler_puzzle_padrao(FILE *file, int *flag)
 				return e;
 			cLidas++;
 		}
+		if (cLidas == 0 && ch == EOF)
+			break;
 		if (cLidas != n_col)
 		{
 			*flag = 0;
@@ -79,6 +210,84 @@ static ESTADO ler_puzzle_padrao(FILE *file, int *flag)
 	return e;
 }
 
+/**
+\brief
+	Lê a grelha de um mapa prédefinido, com uma só leitura a partir da posição dada pelo índice.
+	@param file descritor de ficheiro FILE já aberto.
+	@param x entrada do índice do mapa.
+	@param completo endereço onde é colocado 1 se todas as linhas foram lidas, ou 0 caso contrário.
+
+	@returns Devolve o @c ESTADO lido. Caso uma linha seja inválida, a leitura para nessa linha.
+*/
+static ESTADO ler_mapa(FILE *file, ENTRADA *x, int *completo)
+{
+	ESTADO e = makeState(NULL);
+	char *buf;
+	size_t tam, lidos = 0, k;
+	int i, j, flag = 0;
+
+	if (x->lins > 0 && x->lins <= MAX_GRID && x->cols > 0 && x->cols <= MAX_GRID)
+	{
+		setE_lins(e, x->lins);
+		setE_cols(e, x->cols);
+		setE_base(e, NULL);
+
+		tam = (size_t)x->lins * (x->cols + 1);
+		buf = malloc(tam);
+		flag = 1;
+		if (!fseek(file, (long)x->off, SEEK_SET))
+			lidos = fread(buf, 1, tam, file);
+
+		for (i = 0; i < x->lins && flag; i++)
+			for (j = 0; j <= x->cols && flag; j++)
+			{
+				k = (size_t)i * (x->cols + 1) + j;
+				if (j == x->cols)
+					flag = (k >= lidos || buf[k] == '\n');
+				else if (k >= lidos)
+					flag = 0;
+				else
+					setE_elem(e, i, j, convertFl(buf[k], &flag));
+			}
+		free(buf);
+	}
+
+	*completo = flag;
+	setE_menu(e, PLAY_TAB);
+	setE_flag(e, 0);
+	return e;
+}
+
+/**
+\brief
+	Copia a grelha de um mapa de um pacote, sem a ler.
+	@param c catálogo com o pacote mapeado em memória.
+	@param x entrada do pacote do mapa.
+
+	@returns Devolve o @c ESTADO lido.
+*/
+static ESTADO ler_pacote(CATALOGO c, ENTRADA *x)
+{
+	ESTADO e = makeState(NULL);
+	const char *g = (const char *)c->mapa + x->off;
+	int i, j;
+
+	if (x->lins > 0 && x->lins <= MAX_GRID && x->cols > 0 && x->cols <= MAX_GRID &&
+		x->off >= 0 && (size_t)x->off + TAM_PACOTE(x) <= c->tamMapa)
+	{
+		setE_lins(e, x->lins);
+		setE_cols(e, x->cols);
+		setE_base(e, NULL);
+		for (i = 0; i < x->lins; i++)
+			for (j = 0; j < x->cols; j++)
+				setE_elem(e, i, j, g[i * x->cols + j]);
+	}
+
+	setE_menu(e, PLAY_TAB);
+	setE_flag(e, 0);
+	return e;
+}
+
 /**
 \brief Verifica a validade de uma determinada peça.
 
@@ -113,6 +322,308 @@ static char convertFl(char ch, int *flag)
 	return rval;
 }
 
+/**
+\brief Mapeia em memória o índice de um catálogo, caso este corresponda ao ficheiro de mapas.
+
+No pacote, as grelhas seguem-se às entradas, pelo que o ficheiro pode ser maior que o índice.
+
+@param c Catálogo com o ficheiro de mapas aberto.
+@param idx Caminho do índice, ou do pacote.
+@param st Informação do ficheiro de mapas.
+@param magic @c CATALOGO_MAGIC ou @c PACOTE_MAGIC .
+
+@returns 0 em caso de sucesso, -1 caso o índice não exista ou tenha de ser refeito.
+*/
+static int abreIndice(CATALOGO c, char *idx, struct stat *st, const char *magic)
+{
+	struct stat si;
+	CABECALHO *cab;
+	void *m;
+	int fd = open(idx, O_RDONLY);
+
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &si) || (size_t)si.st_size < sizeof(CABECALHO))
+	{
+		close(fd);
+		return -1;
+	}
+	m = mmap(NULL, si.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (m == MAP_FAILED)
+		return -1;
+
+	cab = m;
+	if (memcmp(cab->magic, magic, 4) || cab->versao != CATALOGO_VERSAO || cab->n < 0 ||
+		cab->tam != (int64_t)st->st_size || cab->mtime != (int64_t)st->st_mtime ||
+		(size_t)si.st_size < sizeof(CABECALHO) + sizeof(ENTRADA) * cab->n ||
+		(strcmp(magic, PACOTE_MAGIC) && (size_t)si.st_size != sizeof(CABECALHO) + sizeof(ENTRADA) * cab->n))
+	{
+		munmap(m, si.st_size);
+		return -1;
+	}
+	c->mapa = m;
+	c->tamMapa = si.st_size;
+	c->v = (ENTRADA *)(cab + 1);
+	c->n = cab->n;
+	c->pacote = !strcmp(magic, PACOTE_MAGIC);
+	return 0;
+}
+
+/**
+\brief Constrói o índice de um catálogo, percorrendo uma vez o ficheiro de mapas.
+
+Cada mapa começa com o marcador @c ::> seguido do seu ID, e das dimensões, separadas por um espaço
+ou uma vírgula. Caso um ID se repita, só conta o primeiro.
+
+@param c Catálogo com o ficheiro de mapas aberto.
+*/
+static void constroiIndice(CATALOGO c)
+{
+	char str[4048];
+	int id, cap = 16, ch, k, m;
+	ENTRADA x;
+
+	c->v = malloc(sizeof(ENTRADA) * cap);
+	c->n = 0;
+	rewind(c->file);
+	while (fscanf(c->file, "%4047s", str) == 1)
+	{
+		if (strcmp("::>", str) || fscanf(c->file, "%d", &id) != 1)
+			continue;
+		memset(&x, 0, sizeof(ENTRADA));
+		x.id = id;
+		x.valido = -1;
+		x.nsol = -1;
+		if (fscanf(c->file, "%d%*[ ,]%d", &x.lins, &x.cols) == 2)
+			while ((ch = fgetc(c->file)) != '\n' && ch != EOF)
+				;
+		else
+			x.lins = x.cols = 0;
+		x.off = ftell(c->file);
+		if (c->n == cap)
+		{
+			cap *= 2;
+			c->v = realloc(c->v, sizeof(ENTRADA) * cap);
+		}
+		c->v[c->n++] = x;
+	}
+
+	qsort(c->v, c->n, sizeof(ENTRADA), cmpEntrada);
+	for (m = 0, k = 0; k < c->n; k++)
+		if (m == 0 || c->v[k].id != c->v[m - 1].id)
+			c->v[m++] = c->v[k];
+	c->n = m;
+}
+
+/**
+\brief Guarda o índice, ou o pacote, de um catálogo ao lado do ficheiro de mapas.
+
+O ficheiro é escrito num ficheiro temporário, que passa a ser o índice de uma só vez.
+Caso não possa ser escrito, o catálogo continua a usar o índice em memória.
+
+@param nome Caminho do índice, do pacote, ou dos metadados.
+@param cab Cabeçalho.
+@param v As @c cab->n entradas.
+@param tamEntrada Tamanho de cada entrada.
+@param dados Grelhas do pacote, miniaturas dos metadados, ou NULL.
+@param tam Tamanho de @p dados .
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+static int guarda(char *nome, CABECALHO *cab, const void *v, size_t tamEntrada, const char *dados, size_t tam)
+{
+	char *tmp = malloc(strlen(nome) + 16);
+	FILE *fp;
+	int ok = 0;
+
+	sprintf(tmp, "%s.%d", nome, (int)getpid());
+	if ((fp = fopen(tmp, "w")) != NULL)
+	{
+		ok = fwrite(cab, sizeof(CABECALHO), 1, fp) == 1 &&
+			 (cab->n == 0 || fwrite(v, tamEntrada, cab->n, fp) == (size_t)cab->n) &&
+			 (tam == 0 || fwrite(dados, 1, tam, fp) == tam);
+		if (fclose(fp) || !ok || rename(tmp, nome))
+		{
+			unlink(tmp);
+			ok = 0;
+		}
+	}
+	free(tmp);
+	return ok ? 0 : -1;
+}
+
+/**
+\brief Preenche o cabeçalho do índice, ou do pacote, de um ficheiro de mapas.
+
+@param cab Cabeçalho.
+@param magic @c CATALOGO_MAGIC ou @c PACOTE_MAGIC .
+@param n Número de mapas.
+@param st Informação do ficheiro de mapas.
+*/
+static void cabecalho(CABECALHO *cab, const char *magic, int n, struct stat *st)
+{
+	memset(cab, 0, sizeof(CABECALHO));
+	memcpy(cab->magic, magic, 4);
+	cab->versao = CATALOGO_VERSAO;
+	cab->n = n;
+	cab->tam = st->st_size;
+	cab->mtime = st->st_mtime;
+}
+
+/**
+\brief Abre um ficheiro de mapas, num catálogo ainda sem índice.
+
+@param path Caminho do ficheiro de mapas.
+@param st Onde é colocada a informação do ficheiro de mapas.
+
+@returns O catálogo, ou NULL caso o ficheiro não exista.
+*/
+static CATALOGO abreTexto(char *path, struct stat *st)
+{
+	CATALOGO c;
+	FILE *file = fopen(path, "r");
+
+	if (!file)
+		return NULL;
+	if (fstat(fileno(file), st))
+	{
+		fclose(file);
+		return NULL;
+	}
+	c = calloc(1, sizeof(struct catalogo));
+	c->file = file;
+	c->path = strdup(path);
+	c->st = *st;
+	return c;
+}
+
+/**
+\brief Caminho de um ficheiro guardado ao lado de um ficheiro de mapas.
+
+@param path Caminho do ficheiro de mapas.
+@param ext Extensão do ficheiro, acrescentada a @p path .
+
+@returns O caminho, que deve ser libertado com @c free .
+*/
+static char *sidecar(char *path, const char *ext)
+{
+	char *nome = malloc(strlen(path) + strlen(ext) + 1);
+	sprintf(nome, "%s%s", path, ext);
+	return nome;
+}
+
+/**
+\brief Metadados de um mapa, mapeando os metadados do catálogo no primeiro pedido.
+
+Só há metadados quando o catálogo usa um pacote, e estes correspondem ao mesmo ficheiro de mapas.
+
+@param c Catálogo.
+@param x Entrada do mapa.
+
+@returns Os metadados, ou NULL caso não existam.
+*/
+static METADADOS *metaMapa(CATALOGO c, ENTRADA *x)
+{
+	struct stat si;
+	CABECALHO *cab;
+	METADADOS *m;
+	void *p;
+	char *nome;
+	int fd;
+
+	if (!c->metaAberto && c->pacote)
+	{
+		c->metaAberto = 1;
+		nome = sidecar(c->path, META_EXT);
+		fd = open(nome, O_RDONLY);
+		free(nome);
+		if (fd >= 0 && !fstat(fd, &si) && (size_t)si.st_size >= sizeof(CABECALHO) &&
+			(p = mmap(NULL, si.st_size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED)
+		{
+			cab = p;
+			if (memcmp(cab->magic, META_MAGIC, 4) || cab->versao != CATALOGO_VERSAO || cab->n != c->n ||
+				cab->tam != (int64_t)c->st.st_size || cab->mtime != (int64_t)c->st.st_mtime ||
+				(size_t)si.st_size < sizeof(CABECALHO) + sizeof(METADADOS) * cab->n)
+				munmap(p, si.st_size);
+			else
+			{
+				c->meta = p;
+				c->tamMeta = si.st_size;
+			}
+		}
+		if (fd >= 0)
+			close(fd);
+	}
+	if (!c->meta || !x)
+		return NULL;
+	m = (METADADOS *)((CABECALHO *)c->meta + 1) + (x - c->v);
+	if (m->id != x->id || m->off < 0 || m->tam < 0 || (size_t)(m->off + m->tam) > c->tamMeta)
+		return NULL;
+	return m;
+}
+
+/**
+\brief Dificuldade de um mapa, de 1 a 5, pela proporção de peças livres que estão por preencher.
+
+Um mapa com mais que uma solução é um nível mais fácil.
+
+@param g Grelha do mapa por resolver, tal como é guardada no pacote.
+@param n Número de peças da grelha.
+@param nsol Número de soluções do mapa.
+
+@returns A dificuldade, ou 0 caso o mapa não tenha solução.
+*/
+static int dificuldade(const char *g, int n, long nsol)
+{
+	int k, livres = 0, vazias = 0, d;
+
+	for (k = 0; k < n; k++)
+	{
+		livres += (g[k] != BLOQUEADA);
+		vazias += (g[k] == VAZIA);
+	}
+	if (nsol <= 0 || livres == 0)
+		return 0;
+	d = 1 + (4 * vazias) / livres;
+	if (nsol > 1 && d > 1)
+		d--;
+	return d;
+}
+
+/**
+\brief Compara duas entradas do índice, por ID e, para o mesmo ID, pela posição no ficheiro.
+*/
+static int cmpEntrada(const void *a, const void *b)
+{
+	const ENTRADA *x = a, *y = b;
+	if (x->id != y->id)
+		return (x->id < y->id) ? -1 : 1;
+	return (x->off > y->off) - (x->off < y->off);
+}
+
+/**
+\brief Procura um mapa no índice de um catálogo, por pesquisa binária.
+
+@param c Catálogo.
+@param id ID do mapa.
+
+@returns A entrada do mapa, ou NULL caso não exista.
+*/
+static ENTRADA *procuraMapa(CATALOGO c, int id)
+{
+	int lo = 0, hi = c->n, m;
+	while (lo < hi)
+	{
+		m = lo + (hi - lo) / 2;
+		if (c->v[m].id < id)
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return (lo < c->n && c->v[lo].id == id) ? c->v + lo : NULL;
+}
+
 // ------------------------------------------------------------------------------
 
 /**
@@ -125,51 +636,279 @@ static char convertFl(char ch, int *flag)
 */
 ESTADO select_arcade(char *path, int id)
 {
-	FILE *file;
-	ESTADO e = makeState(NULL);
-	int cur_id;
-	char str[4048];
-	int flag;
-
-	file = fopen(path, "r");
+	CATALOGO c = abreCatalogo(path);
+	ESTADO e;
 
-	if (!file)
+	if (!c)
 	{
+		e = makeState(NULL);
 		setE_flag(e, -1);
 		return e;
 	}
+	e = leMapa(c, id);
+	fechaCatalogo(c);
+	return e;
+}
+
+/**
+\brief
+	Abre o catálogo de um ficheiro de mapas prédefinidos.
 
-	do
+	O pacote, ou o índice, guardado ao lado do ficheiro é mapeado em memória. Caso nenhum exista,
+	ou o ficheiro de mapas tenha mudado, o índice é construído e guardado.
+	@param path Caminho do ficheiro de mapas.
+
+	@returns Devolve o catálogo, que deve ser fechado com @c fechaCatalogo , ou NULL caso o ficheiro não exista.
+*/
+CATALOGO abreCatalogo(char *path)
+{
+	struct stat st;
+	CABECALHO cab;
+	CATALOGO c = abreTexto(path, &st);
+	char *nome;
+
+	if (!c)
+		return NULL;
+	nome = sidecar(path, PACOTE_EXT);
+	if (abreIndice(c, nome, &st, PACOTE_MAGIC))
 	{
-		flag = 1;
-		do
+		free(nome);
+		nome = sidecar(path, CATALOGO_EXT);
+		if (abreIndice(c, nome, &st, CATALOGO_MAGIC))
 		{
-			flag = fscanf(file, "%s", str);
+			constroiIndice(c);
+			cabecalho(&cab, CATALOGO_MAGIC, c->n, &st);
+			guarda(nome, &cab, c->v, sizeof(ENTRADA), NULL, 0);
+		}
+	}
+	free(nome);
+	return c;
+}
 
-			if (EOF == flag)
-			{
-				fclose(file);
-				return e;
-			}
+/**
+\brief
+	Fecha um catálogo aberto com @c abreCatalogo .
+	@param c Catálogo.
+*/
+void fechaCatalogo(CATALOGO c)
+{
+	if (c->mapa)
+		munmap(c->mapa, c->tamMapa);
+	else
+		free(c->v);
+	if (c->meta)
+		munmap(c->meta, c->tamMeta);
+	fclose(c->file);
+	free(c->path);
+	free(c);
+}
+
+/**
+\brief
+	Número de mapas de um catálogo.
+	@param c Catálogo.
+
+	@returns Devolve o número de mapas.
+*/
+int nMapas(CATALOGO c)
+{
+	return c->n;
+}
+
+/**
+\brief
+	ID de um mapa de um catálogo, pela ordem dos IDs.
+	@param c Catálogo.
+	@param k Posição do mapa, a partir de 0.
+
+	@returns Devolve o ID, ou -1 caso a posição não exista.
+*/
+int idMapa(CATALOGO c, int k)
+{
+	return (k >= 0 && k < c->n) ? c->v[k].id : -1;
+}
+
+/**
+\brief
+	Lê um mapa de um catálogo.
+	@param c Catálogo.
+	@param id ID do mapa.
+
+	@returns Devolve o @c ESTADO com o mapa, ou um @c ESTADO vazio caso o mapa não exista.
+*/
+ESTADO leMapa(CATALOGO c, int id)
+{
+	ENTRADA *x = procuraMapa(c, id);
+	int completo;
+
+	if (!x)
+		return makeState(NULL);
+	if (c->pacote)
+		return ler_pacote(c, x);
+	return ler_mapa(c->file, x, &completo);
+}
+
+/**
+\brief
+	Indica se um mapa de um catálogo é válido, segundo o pacote compilado.
+	@param c Catálogo.
+	@param id ID do mapa.
+
+	@returns Devolve 1 se o mapa for válido, 0 se não for ou não existir, e -1 caso o catálogo
+	não use um pacote e a validade tenha de ser verificada com @c validTab .
+*/
+int validoMapa(CATALOGO c, int id)
+{
+	ENTRADA *x = procuraMapa(c, id);
+	return x ? x->valido : 0;
+}
+
+/**
+\brief
+	Número de soluções de um mapa de um catálogo, segundo o pacote compilado.
+	@param c Catálogo.
+	@param id ID do mapa.
+
+	@returns Devolve o número de soluções, ou -1 caso não seja conhecido.
+*/
+long solucoesMapa(CATALOGO c, int id)
+{
+	ENTRADA *x = procuraMapa(c, id);
+	return x ? (long)x->nsol : -1;
+}
 
-		} while (strcmp("::>", str));
+/**
+\brief
+	Dificuldade de um mapa de um catálogo, segundo os metadados.
+	@param c Catálogo.
+	@param id ID do mapa.
+
+	@returns Devolve a dificuldade, de 1 a 5, 0 se o mapa não tiver solução, ou -1 caso não seja conhecida.
+*/
+int dificuldadeMapa(CATALOGO c, int id)
+{
+	METADADOS *m = metaMapa(c, procuraMapa(c, id));
+	return m ? m->dificuldade : -1;
+}
+
+/**
+\brief
+	Miniatura de um mapa de um catálogo, já desenhada, segundo os metadados.
+
+	A miniatura é um fragmento SVG, desenhado com o tamanho @c MINIATURA a partir da origem.
+	@param c Catálogo.
+	@param id ID do mapa.
+	@param tam Endereço onde é colocado o tamanho do fragmento.
+
+	@returns Devolve o fragmento, que não termina em '\\0', ou NULL caso não seja conhecido.
+*/
+const char *miniaturaMapa(CATALOGO c, int id, size_t *tam)
+{
+	METADADOS *m = metaMapa(c, procuraMapa(c, id));
+	if (!m)
+		return NULL;
+	*tam = m->tam;
+	return (const char *)c->meta + m->off;
+}
+
+/**
+\brief
+	Compila um ficheiro de mapas prédefinidos num pacote, guardado ao lado deste.
 
-		flag = fscanf(file, "%d", &cur_id);
+	Cada mapa é lido e validado uma só vez, e os mapas válidos são resolvidos. O pacote guarda,
+	por ordem de ID, a grelha de cada mapa, já convertida, a validade, o número de soluções e uma solução.
+	Caso seja dada uma função de desenho, são também guardados os metadados, com a dificuldade e a
+	miniatura de cada mapa.
+	@param path Caminho do ficheiro de mapas.
+	@param log Ficheiro onde é escrito um resumo de cada mapa, ou NULL.
+	@param desenha Função que desenha a miniatura de um mapa, ou NULL.
 
-		if (EOF == flag)
+	@returns Devolve o número de mapas compilados, ou -1 em caso de erro.
+*/
+int compilaCatalogo(char *path, FILE *log, DESENHO desenha)
+{
+	struct stat st;
+	CABECALHO cab;
+	CATALOGO c = abreTexto(path, &st);
+	ENTRADA *x;
+	ESTADO e;
+	METADADOS *meta;
+	char *dados, *nome, *g, *svg, *mini = NULL, val;
+	size_t tam = 0, pos = 0, k, tamSvg, tamMini = 0;
+	long nsol;
+	int i, j, m, completo, r;
+
+	if (!c)
+		return -1;
+	constroiIndice(c);
+	for (m = 0; m < c->n; m++)
+	{
+		x = c->v + m;
+		if (x->lins <= 0 || x->lins > MAX_GRID || x->cols <= 0 || x->cols > MAX_GRID)
+			x->lins = x->cols = 0;
+		tam += TAM_PACOTE(x);
+	}
+
+	dados = calloc(1, tam + 1);
+	meta = calloc(c->n + 1, sizeof(METADADOS));
+	for (m = 0; m < c->n; m++)
+	{
+		x = c->v + m;
+		e = ler_mapa(c->file, x, &completo);
+		x->valido = completo && validTab(e);
+		x->nsol = 0;
+		x->off = sizeof(CABECALHO) + sizeof(ENTRADA) * c->n + pos;
+		g = dados + pos;
+		for (i = 0; i < x->lins; i++)
+			for (j = 0; j < x->cols; j++)
+				g[i * x->cols + j] = getE_elem(e, i, j);
+
+		meta[m].id = x->id;
+		if (desenha && (svg = desenha(e, &tamSvg)) != NULL)
 		{
-			fclose(file);
-			return e;
+			mini = realloc(mini, tamMini + tamSvg + 1);
+			memcpy(mini + tamMini, svg, tamSvg);
+			meta[m].off = sizeof(CABECALHO) + sizeof(METADADOS) * c->n + tamMini;
+			meta[m].tam = tamSvg;
+			tamMini += tamSvg;
+			free(svg);
 		}
 
-	} while (id != cur_id);
+		if (x->valido)
+		{
+			e = solve(e, &nsol);
+			x->nsol = nsol;
+			for (i = 0, k = 0; nsol > 0 && i < x->lins; i++)
+				for (j = 0; j < x->cols; j++, k++)
+					if ((val = getE_elem(e, i, j)) == SOL_X || val == FIXO_X)
+						g[x->lins * x->cols + k / 8] |= (char)(1 << (k % 8));
+		}
+		meta[m].dificuldade = dificuldade(g, x->lins * x->cols, x->nsol);
+		pos += TAM_PACOTE(x);
+		destroyState(e);
 
-	e = ler_puzzle_padrao(file, &flag);
-	setE_menu(e, PLAY_TAB);
-	setE_flag(e, 0);
+		if (log)
+			fprintf(log, "::> %d %dx%d %s %ld %d\n", x->id, x->lins, x->cols,
+					x->valido ? "válido" : "inválido", (long)x->nsol, meta[m].dificuldade);
+	}
 
-	fclose(file);
-	return e;
+	nome = sidecar(path, PACOTE_EXT);
+	cabecalho(&cab, PACOTE_MAGIC, c->n, &st);
+	r = guarda(nome, &cab, c->v, sizeof(ENTRADA), dados, tam) ? -1 : c->n;
+	free(nome);
+	if (r >= 0 && desenha)
+	{
+		nome = sidecar(path, META_EXT);
+		cabecalho(&cab, META_MAGIC, c->n, &st);
+		if (guarda(nome, &cab, meta, sizeof(METADADOS), mini, tamMini))
+			r = -1;
+		free(nome);
+	}
+	free(mini);
+	free(meta);
+	free(dados);
+	fechaCatalogo(c);
+	return r;
 }
 
 /**
@@ -195,6 +934,7 @@ ESTADO select_padrao(char *path, char *map, int *flag)
 		*flag = 0;
 		return e;
 	}
+	destroyState(e);
 	e = ler_puzzle_padrao(file, flag);
 	setE_menu(e, PLAY_TAB);
 	setE_flag(e, 0);
@@ -9,9 +9,50 @@
 #include "estado.h"
 #include "solver.h"
 #include "cgi.h"
+#include <stddef.h>
 
 // ------------------------------------------------------------------------------
 
+/**
+\brief Declaração do catálogo dos mapas prédefinidos.
+*/
+typedef struct catalogo * CATALOGO;
+
+/**
+\brief Extensão do índice de um ficheiro de mapas prédefinidos, guardado ao lado deste.
+*/
+#define CATALOGO_EXT ".idx"
+
+/**
+\brief Extensão do pacote compilado de um ficheiro de mapas prédefinidos, guardado ao lado deste.
+*/
+#define PACOTE_EXT ".pack"
+
+/**
+\brief Extensão dos metadados de um ficheiro de mapas prédefinidos, guardados ao lado deste.
+*/
+#define META_EXT ".meta"
+
+/**
+\brief Tamanho com que são desenhadas as miniaturas dos mapas.
+*/
+#define MINIATURA 200
+
+/**
+\brief Função que desenha a miniatura de um mapa, com o tamanho @c MINIATURA , para @c compilaCatalogo .
+
+Recebe o mapa por resolver e o endereço onde colocar o tamanho do desenho, devolvendo
+o fragmento SVG, que deve ser libertado com @c free , ou NULL em caso de erro.
+*/
+typedef char *(*DESENHO)(ESTADO e, size_t *tam);
+
+/**
+\brief Macro para abrir o catálogo dos mapas prédefinidos.
+
+@returns catálogo aberto, ou NULL caso o ficheiro de mapas não exista
+*/
+#define CATALOGO_ARCADE() abreCatalogo(FILE_PATH)
+
 /**
 \brief Macro para ler um mapa prédefinido
 
@@ -35,6 +76,26 @@
 
 ESTADO select_arcade(char *path, int id);
 
+CATALOGO abreCatalogo(char *path);
+
+void fechaCatalogo(CATALOGO c);
+
+int nMapas(CATALOGO c);
+
+int idMapa(CATALOGO c, int k);
+
+ESTADO leMapa(CATALOGO c, int id);
+
+int validoMapa(CATALOGO c, int id);
+
+long solucoesMapa(CATALOGO c, int id);
+
+int dificuldadeMapa(CATALOGO c, int id);
+
+const char *miniaturaMapa(CATALOGO c, int id, size_t *tam);
+
+int compilaCatalogo(char *path, FILE *log, DESENHO desenha);
+
 ESTADO select_padrao( char * path, char * map, int * flag);
 
 ESTADO select_random(int id, int * flag);
@@ -18,6 +18,7 @@
 
 /* Metódos públicos */
 void printstate (ESTADO state, int windowsize);
+void printdiff (ESTADO antes, int ramos, ESTADO state);
 void selectFile(char * nameTag, char * tag);
 
 /* Metódos privados */
@@ -25,6 +26,7 @@ static void drawMenuDesignValidate(ESTADO state, int windowsize);
 static void drawMenuTabDesignStack(ESTADO state, int windowsize);
 static void drawMenuDesignSize(ESTADO state, int windowsize);
 static void drawbuttonsplayStack(ESTADO state, int windowsize);
+static void drawCheckpoints(ESTADO state, int windowsize);
 static void buttonPlacer (int x, int y, int size, char* link, char* pic);
 static void circulateButtons(ESTADO state, int windowsize, int menuPrev, int menuNext);
 static void drawMenuTabDesign(ESTADO state, int windowsize);
@@ -43,15 +45,15 @@ static void helpP11(ESTADO state, int windowsize);
 static void helpP12(ESTADO state, int windowsize);
 static void helpP13(ESTADO state, int windowsize);
 static void helpP14(ESTADO state, int windowsize);
-static void trofyPlacer(int windowsize, int NLeader);
+static void trofyPlacer(int windowsize, int ini, int NLeader);
 static void scorePlacer(int windowsize, int NLeader, INFO v);
 
 // ------------------------------------------------------------------------------
 
 /**
-\brief Constante que representa o número de mapas pré-definidos
+\brief Constante que representa o número de mapas pré-definidos em cada página do menu de escolher mapas
 */
-#define NMAPS 7
+#define MAPAS_POR_PAGINA 8
 
 /**
 \brief Macro para criar um valor de margem para trabalhar em frontend
@@ -80,6 +82,11 @@ static void scorePlacer(int windowsize, int NLeader, INFO v);
 */
 #define SIZE(windowsize, x, d) (d? (((windowsize*x)/16) + (windowsize/(16*d))) : ((windowsize*x)/16))
 
+/**
+\brief Número máximo de checkpoints com nome listados no menu de jogo
+*/
+#define NCHECKPOINTS 6
+
 
 // ------------------------------------------------------------------------------
 /**
@@ -370,13 +377,15 @@ static void drawHint(ESTADO state, int windowsize)
 
 /**
 \brief Função auxiliar para o Menu jogar
-Desenha undo/redo e ancoras
+Desenha undo/redo, os ramos do redo e ancoras
 @param state o estado a desenhar
 @param windowsize tamanho da área disponível para desenhar
 */
 static void drawbuttonsplayStack(ESTADO state, int windowsize)
 {
 	char link[MAX_BUFFER];
+	char texto[32];
+	int n;
 	//load checkpoint	
 	sprintf(link, "%s/%s",getE_user(state), "getAnc");
 	buttonPlacer(
@@ -413,7 +422,58 @@ static void drawbuttonsplayStack(ESTADO state, int windowsize)
 		link,
 		"redo.png");
 
+	//ligação para alternar o ramo seguido pelo redo
+	n = nRamos(getE_hist(state));
+	if (n > 1)
+	{
+		sprintf(link, "http://localhost/cgi-bin/GandaGalo?%s/%s",getE_user(state), "branch");
+		sprintf(texto, "Redo branches: %d", n);
+		ABRIR_LINK(link);
+			TEXT(
+			calculate(windowsize, 0, 0, 2),
+			calculate(windowsize, 1, -1, 2),
+			"blue",
+			texto);
+		FECHAR_LINK;
+	}
+
+	drawCheckpoints(state, windowsize);
+}
+
+/**
+\brief Função que lista os checkpoints com nome, do mais recente para o mais antigo
+@param state o estado a desenhar
+@param windowsize tamanho da área disponível para desenhar
+*/
+static void drawCheckpoints(ESTADO state, int windowsize)
+{
+	char link[MAX_BUFFER];
+	char * nome;
+	HISTORIA h = getE_hist(state);
+	int k, n = 0;
+
+	for (k = nAnc(h) - 1; k >= 0 && n < NCHECKPOINTS; k--)
+	{
+		nome = getAnc_nome(h, k);
+		if (!*nome) continue;
+		if (!n)
+			TEXT(
+			calculate(windowsize, 0, 4, 0),
+			calculate(windowsize, 0, 6, 2),
+			"black",
+			"Checkpoints:");
+		n++;
+		sprintf(link, "http://localhost/cgi-bin/GandaGalo?%s/getAnc=%s", getE_user(state), nome);
+		ABRIR_LINK(link);
+			TEXT(
+			calculate(windowsize, 0, 4, 2),
+			calculate(windowsize, 0, 6, 2 + 3 * n),
+			"blue",
+			nome);
+		FECHAR_LINK;
+	}
 }
+
 /**
 \brief Função para o Menu jogar
 @param state o estado a desenhar
@@ -463,41 +523,87 @@ static void drawbuttonsplay(ESTADO state, int windowsize)
 
 /**
 \brief Função que desenha o menu de escolher mapas
+
+É desenhada a página @c getE_pagina dos mapas do catálogo, com @c MAPAS_POR_PAGINA mapas,
+e os botões para as páginas anterior e seguinte. O catálogo é aberto uma só vez.
+
 @param state o estado a desenhar
 @param windowsize tamanho da área disponível para desenhar
 */
 static void drawPickMap(ESTADO state, int  windowsize)
 {
 	ESTADO aux;
+	CATALOGO c = CATALOGO_ARCADE();
 	char link [MAX_BUFFER];
-	int i,j;
-	int idMap = 1;
+	const char *svg;
+	size_t tam;
+	int i,j,x,y,id,dif;
+	int pagina = getE_pagina(state);
+	int k = pagina * MAPAS_POR_PAGINA;
+	int fim = c ? nMapas(c) : 0;
 	int ncoll = 2;
 	int nlins = 3;
 
+	if (fim > k + MAPAS_POR_PAGINA)
+		fim = k + MAPAS_POR_PAGINA;
+
 	TEXT(
 	calculate(windowsize, 0, 0, 0),
 	calculate(windowsize, 0, 0, 2),
 	"black",
 	"Select Map:");
 
-    for (i = 1; i <= ncoll && idMap <= NMAPS; ++i){
-    	for (j = 0; j <=nlins && idMap <= NMAPS; ++j){
-
-    		aux = SELECT(idMap);
-    		setE_menu(aux,SELECT_MAP);
-
-    	    mapPlacer(
-    	    	j * SIZE(windowsize,4,2), 
-    	    	(i - 1) * SIZE(windowsize, 4, 2) + calculate(windowsize, 0, 1, 0),
-    	    	SIZE(windowsize, 4, 0),
-    	    	idMap,
-    	    	aux,
-    	    	getE_user(state));
-    	    idMap++;
+    for (i = 1; i <= ncoll && k < fim; ++i){
+    	for (j = 0; j <=nlins && k < fim; ++j){
+
+    		id = idMapa(c, k);
+    		x = j * SIZE(windowsize,4,2);
+    		y = (i - 1) * SIZE(windowsize, 4, 2) + calculate(windowsize, 0, 1, 0);
+
+    		//miniatura já desenhada pelo compilador de mapas
+    		if ((svg = miniaturaMapa(c, id, &tam)) != NULL)
+    			miniaturaPlacer(x, y, SIZE(windowsize, 4, 0), id, svg, tam, getE_user(state));
+    		else {
+    			aux = leMapa(c, id);
+    			setE_menu(aux,SELECT_MAP);
+    			mapPlacer(x, y, SIZE(windowsize, 4, 0), id, aux, getE_user(state));
+    			destroyState(aux);
+    		}
+
+    		if ((dif = dificuldadeMapa(c, id)) > 0){
+    			sprintf(link, "Difficulty: %d/5", dif);
+    			TEXT(x, y + SIZE(windowsize, 4, 0) + TEXTMARGIN(windowsize) * 2, "black", link);
+    		}
+    	    k++;
     	}
     }
 
+	if (pagina > 0)
+	{
+	    //botão para a página anterior
+	    sprintf(link, "%s/P%d",getE_user(state), pagina - 1);
+	    buttonPlacer(
+	    	calculate(windowsize, 0, 0, 0),
+	    	calculate(windowsize, 1, -2, 3),
+	    	SIZE(windowsize, 1, 2),
+	    	link,
+	    	"undo.png");
+	}
+
+	if (c && nMapas(c) > fim)
+	{
+	    //botão para a página seguinte
+	    sprintf(link, "%s/P%d",getE_user(state), pagina + 1);
+	    buttonPlacer(
+	    	calculate(windowsize, 0, 1, 0),
+	    	calculate(windowsize, 1, -2, 3),
+	    	SIZE(windowsize, 1, 2),
+	    	link,
+	    	"redo.png");
+	}
+	if (c)
+		fechaCatalogo(c);
+
     //botão para voltar ao menu anterior
 	sprintf(link, "%s/%s",getE_user(state), "M2");
 	buttonPlacer(
@@ -506,8 +612,6 @@ static void drawPickMap(ESTADO state, int  windowsize)
 		SIZE(windowsize, 3 ,0),
 		link,
 		"back.png");
-	
-	destroyState(aux);
 }
 
 /**
@@ -565,6 +669,9 @@ static void drawConfirmMap(ESTADO state, int windowsize)
 {
     
     char link [MAX_BUFFER];
+    CATALOGO c;
+    long nsol;
+    int dif;
 
     sprintf(link, "%s/%s",getE_user(state), "M1");
 	buttonPlacer(
@@ -584,18 +691,44 @@ static void drawConfirmMap(ESTADO state, int windowsize)
 
 	drawTab(state, windowsize/3, windowsize/2 - MARGIN(windowsize), 0);
 
-	
+	//número de soluções e dificuldade, compilados com o mapa
+	if (getE_mapa(state) && (c = CATALOGO_ARCADE()) != NULL){
+		nsol = solucoesMapa(c, getE_mapa(state));
+		dif = dificuldadeMapa(c, getE_mapa(state));
+		fechaCatalogo(c);
+		if (nsol >= 0){
+			sprintf(link, "Number of solutions:%ld", nsol);
+			TEXT(
+				calculate(windowsize, 0, 3, 0),
+				calculate(windowsize, 0, 3, -1),
+				"black",
+				link);
+		}
+		if (dif > 0){
+			sprintf(link, "Difficulty: %d/5", dif);
+			TEXT(
+				calculate(windowsize, 0, 3, 0),
+				calculate(windowsize, 0, 3, -3),
+				"black",
+				link);
+		}
+	}
 }
 
 /**
 \brief Função que desenha o Menu de Vitória
 
+É também escrita a posição do utilizador na leaderboard.
+
 @param state o estado a desenhar
 @param windowsize tamanho da área disponível para desenhar
+
+@see get_rank
 */
 static void drawMenuVictory (ESTADO state,int windowsize)
 {
 	char link [MAX_BUFFER];
+	int rank, total;
 
     //imagem de fundo
     ACU_IMAGE (
@@ -619,6 +752,16 @@ static void drawMenuVictory (ESTADO state,int windowsize)
 		windowsize/3,
 		windowsize/2 - MARGIN(windowsize),
 		0);
+
+    //posição na leaderboard
+	if ((rank = get_rank(getE_user(state), JAN_TOTAL, &total)) > 0){
+		sprintf(link, "#%d of %d", rank, total);
+		TEXT(
+			windowsize/2,
+			calculate(windowsize, 1, -1, 0),
+			"black",
+			link);
+	}
 }
 
 /**
@@ -682,7 +825,7 @@ static void drawMenuInvalidRandom (ESTADO state,int windowsize)
 */
 void selectFile(char * nameTag, char * tag)
 {
-    printf("<form action="">\n %s \n<input type=\"text\" name=\"%s\" \n>\n <br> <input type=\"submit\">\n</form>",nameTag, tag);
+    poeFormato("<form action="">\n %s \n<input type=\"text\" name=\"%s\" \n>\n <br> <input type=\"submit\">\n</form>",nameTag, tag);
 }
 
 /**
@@ -895,20 +1038,33 @@ static void helpP14(ESTADO state, int windowsize)
 /**
 \brief Função que desenha os trofeus no menu de leaderboard
 
+As três primeiras posições têm trofeu, as restantes são escritas.
+
 @param windowsize tamanho da área disponível para desenhar
+@param ini posição do primeiro utilizador a escrever, a partir de 0
 @param NLeader número de utilizadores a escrever
 */
-static void trofyPlacer(int windowsize, int NLeader)
+static void trofyPlacer(int windowsize, int ini, int NLeader)
 {
 	char name[MAX_BUFFER];
 	for(int i = 0; i < NLeader; i++)
 	{
-		sprintf(name, "%dPlace.png", (i + 1));
-		ACU_IMAGE(
-		    calculate(windowsize, 0, 3, 0),
-		    calculate(windowsize, 0, i, 30),
-		    SIZE(windowsize, 1,2),
-		    name);
+		if (ini + i < 3){
+			sprintf(name, "%dPlace.png", (ini + i + 1));
+			ACU_IMAGE(
+			    calculate(windowsize, 0, 3, 0),
+			    calculate(windowsize, 0, i, 30),
+			    SIZE(windowsize, 1,2),
+			    name);
+		}
+		else {
+			sprintf(name, "%d.", (ini + i + 1));
+			TEXT(
+			    calculate(windowsize, 0, 3, 3),
+			    calculate(windowsize, 0, i, 34),
+			    "black",
+			    name);
+		}
 	}
 }
 
@@ -942,9 +1098,39 @@ static void scorePlacer(int windowsize, int NLeader, INFO v)
 	}
 }
 
+/**
+\brief Função que desenha o seletor da janela de tempo no menu de leaderboard
+
+Cada janela é um link para a primeira página da sua leaderboard, e a janela atual é escrita a vermelho.
+
+@param state o estado a desenhar
+@param windowsize tamanho da área disponível para desenhar
+*/
+static void janelaPlacer(ESTADO state, int windowsize)
+{
+	static const char * const nomes[NJANELAS] = {"All time", "Month", "Week", "Day"};
+	char link [MAX_BUFFER];
+
+	for (int k = 0; k < NJANELAS; k++)
+	{
+		sprintf(link, "%s/L0J%d", getE_user(state), k);
+		ABRIR_LINK(link);
+		    TEXT(
+		    	calculate(windowsize, 0, (2 + k), 0),
+		    	calculate(windowsize, 0, 0, 26),
+		    	k == getE_janela(state) ? "red" : "black",
+		    	nomes[k]);
+		FECHAR_LINK;
+	}
+}
+
 /**
 \brief Função que desenha o Menu de leaderboard
 
+É desenhada a página @c getE_pagina da leaderboard da janela de tempo @c getE_janela , com
+@c POR_PAGINA posições, o seletor da janela, e os botões para as páginas anterior e seguinte,
+até à posição @c TOP_K .
+
 @param state o estado a desenhar
 @param windowsize tamanho da área disponível para desenhar
 */
@@ -953,8 +1139,8 @@ static void drawLeaderBoard(ESTADO state, int windowsize)
 	char link [MAX_BUFFER];
 
 	INFO v;
-	int NLeader;
-	NLeader = get_info(&v, 3);
+	int NLeader, pagina = getE_pagina(state), janela = getE_janela(state);
+	NLeader = get_info(&v, janela, pagina * POR_PAGINA, POR_PAGINA + 1);
 
 	ACU_IMAGE(
 		0,
@@ -963,9 +1149,36 @@ static void drawLeaderBoard(ESTADO state, int windowsize)
 		"backLeaderboard.png"
 	);
 
-	trofyPlacer(windowsize, NLeader);
+	janelaPlacer(state, windowsize);
+
+	trofyPlacer(windowsize, pagina * POR_PAGINA, NLeader > POR_PAGINA ? POR_PAGINA : NLeader);
+
+	scorePlacer(windowsize, NLeader > POR_PAGINA ? POR_PAGINA : NLeader, v);
+
+	if (pagina > 0)
+	{
+	    //botão para a página anterior
+	    sprintf(link, "%s/L%dJ%d",getE_user(state), pagina - 1, janela);
+	    buttonPlacer(
+	    	calculate(windowsize, 0, 0, 0),
+	    	calculate(windowsize, 1, -2, 3),
+	    	SIZE(windowsize, 1, 2),
+	    	link,
+	    	"undo.png");
+	}
 
-	scorePlacer(windowsize, NLeader, v);
+	if (NLeader > POR_PAGINA)
+	{
+	    //botão para a página seguinte
+	    sprintf(link, "%s/L%dJ%d",getE_user(state), pagina + 1, janela);
+	    buttonPlacer(
+	    	calculate(windowsize, 0, 1, 0),
+	    	calculate(windowsize, 1, -2, 3),
+	    	SIZE(windowsize, 1, 2),
+	    	link,
+	    	"redo.png");
+	}
+	free(v);
 
 	//botão para voltar ao menu anterior
 	sprintf(link, "%s/%s",getE_user(state), "M7");
@@ -998,6 +1211,9 @@ void printstate (ESTADO state, int windowsize)
 			break;
 
 		case PLAY_TAB:
+		    sprintf(tagger, "%s_saveCheckpoint", getE_user(state));
+		    selectFile("Checkpoint Name:", tagger);
+
 		    ABRIR_SVG(windowsize + 100, windowsize); 
 			    drawbuttonsplay (state, windowsize);
             FECHAR_SVG;
@@ -1095,4 +1311,48 @@ void printstate (ESTADO state, int windowsize)
 	        FECHAR_SVG;
 	        break;
 	}
-}
\ No newline at end of file
+}
+
+/**
+\brief Função que escreve, em JSON, as peças alteradas por uma jogada, em vez da página
+
+A página que foi desenhada antes da jogada é atualizada pelo cliente, que troca as peças indicadas.
+Quando a jogada altera mais que as peças (outro menu, outras dimensões, outros ramos do redo,
+ou o tabuleiro ficou completo), é pedido ao cliente que volte a carregar a página, com @b "r":1 .
+O tabuleiro completo não é tratado aqui, para que a vitória só seja contada por @c printstate .
+
+@param antes cópia do estado antes da jogada, feita com @c snapshotState
+@param ramos número de ramos do redo antes da jogada
+@param state estado depois da jogada
+*/
+void printdiff (ESTADO antes, int ramos, ESTADO state)
+{
+	int i, j, n = 0;
+	int recarregar = getE_menu(antes) != PLAY_TAB || getE_menu(state) != PLAY_TAB ||
+	                 getE_lins(antes) != getE_lins(state) || getE_cols(antes) != getE_cols(state) ||
+	                 nRamos(getE_hist(state)) != ramos || getE_vazias(state) == 0;
+
+	limpaSaida();
+	poeTexto("{\"m\":");
+	poeInt(getE_menu(state));
+	poeTexto(",\"h\":");
+	poeInt(getE_help(state));
+	poeTexto(",\"r\":");
+	poeInt(recarregar);
+	if (!recarregar){
+		poeTexto(",\"c\":[");
+		for (i = 0; i < getE_lins(state); ++i)
+			for (j = 0; j < getE_cols(state); ++j)
+				if (getE_elem(antes, i, j) != getE_elem(state, i, j)){
+					poeTexto(n++ ? ",[" : "[");
+					poeInt(i);
+					poeTexto(",");
+					poeInt(j);
+					poeTexto(",");
+					poeInt(getE_elem(state, i, j));
+					poeTexto("]");
+				}
+		poeTexto("]");
+	}
+	poeTexto("}\n");
+}
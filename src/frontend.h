@@ -6,28 +6,29 @@
 #define frontend_h
 
 #include "estado.h"
+#include "saida.h"
 
 // ------------------------------------------------------------------------------
 
 /**
 \brief Macro para abrir um body com a cor de fundo.
 */
-#define BODY printf("<body bgcolor='#8FD8D8'>\n")
+#define BODY poeTexto("<body bgcolor='#8FD8D8'>\n")
 
 /**
 \brief Macro para fechar o body.
 */
-#define FECHAR_BODY printf("</body>\n")
+#define FECHAR_BODY poeTexto("</body>\n")
 
 /**
 \brief Macro para cria o div que centra.
 */
-#define DIV_CENTRAR printf("<div style='text-align:center;padding:50px'>\n")
+#define DIV_CENTRAR poeTexto("<div style='text-align:center;padding:50px'>\n")
 
 /**
 \brief Macro para fechar div.
 */
-#define FECHAR_DIV printf("</div>\n")
+#define FECHAR_DIV poeTexto("</div>\n")
 
 /**
 \brief Macro para calcular o valor .
@@ -46,13 +47,16 @@
 @param ESCALA A escala da imagem.
 @param FICHEIRO O caminho para o link do ficheiro.
 */
-#define ACU_IMAGE(X, Y, ESCALA, FICHEIRO) printf("<image x=%d y=%d width=%d height=%d xlink:href=%s%s />\n", \
-												 X, Y, ESCALA, ESCALA, IMAGE_PATH, FICHEIRO)
+#define ACU_IMAGE(X, Y, ESCALA, FICHEIRO) (poeTexto("<image x="), poeInt(X), poeTexto(" y="), poeInt(Y), \
+												 poeTexto(" width="), poeInt(ESCALA), poeTexto(" height="), poeInt(ESCALA), \
+												 poeTexto(" xlink:href=" IMAGE_PATH), poeTexto(FICHEIRO), poeTexto(" />\n"))
 
 // ------------------------------------------------------------------------------
 
 void printstate (ESTADO state, int windowsize);
 
+void printdiff (ESTADO antes, int ramos, ESTADO state);
+
 void selectFile(char * nameTag, char * tag);
 
 #endif
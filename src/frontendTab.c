@@ -15,12 +15,14 @@
 // ------------------------------------------------------------------------------
 
 /*  Métodos públicos */
+void defsTab ();
 void drawTab (ESTADO state,int windowsize, int x, int y);
 void mapPlacer (int x, int y, int size, int id, ESTADO state, char * username);
+void miniaturaPlacer (int x, int y, int size, int id, const char * svg, size_t tam, char * username);
 
 /* Métodos privados */
-static void aidimage (int x, int y, int size, char * img, char * buffer,int sign);
-static void putimage (int ox, int oy, int x, int y, int size, int value, char *buffer, char menu, char linker);
+static void putimage (int x, int y, int value, int fixa);
+static void scriptTab ();
 
 // ------------------------------------------------------------------------------
 
@@ -36,74 +38,109 @@ static void putimage (int ox, int oy, int x, int y, int size, int value, char *b
 // ------------------------------------------------------------------------------
 
 /**
-\brief Macro para criar colocar uma peça do tabuleiro
-@param x abcissa do canto superior esquerdo da imagem 
-@param y ordenada do canto superior esquerdo da imagem
-@param size tamanho da imagem
-@param img nome do ficheiro da imagem
-@param buffer hiperligação a colocar na imagem
-@param sign 0 para imprimir a imagem, 1 para imprimir e associar o link
+\brief Imagens das peças, por @c VALOR , definidas uma só vez em cada página por @c defsTab .
 */
-static void aidimage (int x, int y, int size, char * img, char * buffer,int sign)
-{
-	switch(sign)
-	{
-		case 0: ACU_IMAGE(x,y,size,img); break;
-		case 1: ABRIR_LINK(buffer);
-				ACU_IMAGE(x,y,size,img);
-				FECHAR_LINK;
-				break;
-	}
-}
+static const char * const pecas[] = {
+	"bloq2.png",
+	"green_shroom2.png",
+	"mario_coin_darker.png",
+	"vazio.png",
+	"red_shroom2.png",
+	"mario_coin2.png"
+};
+
+/**
+\brief Diferente de 0 depois de as definições das peças terem sido escritas na página.
+*/
+static int defsPostas = 0;
 
 /**
-\brief Macro para criar colocar uma peça do tabuleiro
-@param ox offset da peça no eixo Ox
-@param oy offset da peça no eixo Oy
-@param x número da linha da peça 
-@param y número da coluna da peça
-@param size tamanho da peça
+\brief Diferente de 0 depois de o tratador dos cliques nas peças ter sido escrito na página.
+*/
+static int scriptPosto = 0;
+
+/**
+\brief Função que coloca uma peça do tabuleiro, como referência à sua definição
+
+As coordenadas são em peças, dentro do @c svg do tabuleiro.
+
+@param x número da coluna da peça
+@param y número da linha da peça
 @param value descrição enum da peça
-@param buffer hiperligação a colocar na peça
-@param menu menu onde se encontra o tabuleiro
-@param linker identificação para desenhar soltos com link
+@param fixa 1 para marcar a peça como não clicavél num tabuleiro com links
 */
-static void putimage (int ox, int oy, int x, int y, int size, int value, char *buffer, char menu, char linker)
+static void putimage (int x, int y, int value, int fixa)
 {
+	if (value < BLOQUEADA || value > SOL_O)
+		return;
+	poeTexto(fixa ? "<use class=f xlink:href=#g" : "<use xlink:href=#g");
+	poeInt(value);
+	poeTexto(" x=");
+	poeInt(x);
+	poeTexto(" y=");
+	poeInt(y);
+	poeTexto(" />\n");
+}
 
-	switch (value){
-
-		case BLOQUEADA:
-					aidimage(x*size + ox, y*size + oy,size, "bloq2.png", buffer, !menu);
-					break;
-
-		case FIXO_X: 
-					aidimage(x*size + ox, y*size + oy,size, "green_shroom2.png",buffer,!menu);
-					break;
-		
-		case FIXO_O:
-					aidimage(x*size + ox, y*size + oy,size, "mario_coin_darker.png",buffer,!menu);
-					break;
-
-		case VAZIA: 
-					aidimage(x*size + ox, y*size + oy,size, "vazio.png",buffer,linker);
-					break;
-					
-		case SOL_X: 
-					aidimage(x*size + ox, y*size + oy,size, "red_shroom2.png",buffer,linker);
-					break;
-
-		case SOL_O: 
-					aidimage(x*size + ox, y*size + oy,size, "mario_coin2.png",buffer,linker);
-					break;
-	}
+/**
+\brief Função que escreve o tratador dos cliques nas peças, uma só vez em cada página
+
+Um clique numa peça de um tabuleiro com o atributo @b data-l faz a jogada na peça, pedindo, no
+modo @b json , só as peças alteradas, que são trocadas no tabuleiro sem voltar a carregar a página.
+Caso o servidor o peça, ou o pedido falhe, é carregada a página do utilizador. Sem @b fetch ,
+o clique segue o link da jogada, tal como faziam os links que cada peça tinha.
+*/
+static void scriptTab ()
+{
+	if (scriptPosto)
+		return;
+	scriptPosto = 1;
+	poeTexto("<script>document.addEventListener('click',function(ev){"
+			 "var t=ev.target,b=t.parentNode,l=b&&b.dataset&&b.dataset.l,u;"
+			 "if(t.tagName!='use'||!l||t.getAttribute('class')=='f')return;"
+			 "u=l+'@l'+t.getAttribute('y')+'c'+t.getAttribute('x')+'/';"
+			 "if(!window.fetch){location.href=u;return;}"
+			 "fetch(u+'json').then(function(r){return r.json();}).then(function(d){"
+			 "if(d.r){location.href=l;return;}"
+			 "d.c.forEach(function(c){"
+			 "var e=b.querySelector('use[x=\"'+c[1]+'\"][y=\"'+c[0]+'\"]');"
+			 "if(e)e.setAttributeNS('http://www.w3.org/1999/xlink','href','#g'+c[2]);"
+			 "});"
+			 "}).catch(function(){location.href=l;});"
+			 "});</script>\n");
 }
 
 //----------------------------------------------------------------------------------------
 
+/**
+\brief Função que escreve as definições das imagens das peças, uma só vez em cada página
+
+Cada peça é uma imagem de tamanho 1, referida pelo tabuleiro com um @b use .
+*/
+void defsTab ()
+{
+	int k;
+
+	if (defsPostas)
+		return;
+	defsPostas = 1;
+	poeTexto("<defs>\n");
+	for (k = BLOQUEADA; k <= SOL_O; k++){
+		poeTexto("<image id=g");
+		poeInt(k);
+		poeTexto(" width=1 height=1 xlink:href=" IMAGE_PATH);
+		poeTexto(pecas[k]);
+		poeTexto(" />\n");
+	}
+	poeTexto("</defs>\n");
+}
+
 /**
 \brief Função que desenha o Tabuleiro
 
+O tabuleiro é um @c svg com uma unidade por peça, e as peças referem as definições de @c defsTab .
+Nos menus onde se joga, os cliques nas peças são tratados por @c scriptTab .
+
 @param state estado a desenhar
 @param windowsize tamanho da área disponível para desenhar
 @param x offset do tabuleiro no eixo Ox
@@ -116,18 +153,43 @@ void drawTab (ESTADO state,int windowsize, int x, int y)
 
 	int size = windowsize/lSide;
 
-	int i, j;
-
-	char buffer[MAX_BUFFER];
+	int menu = getE_menu(state), linker = (menu == 0 || menu == 1);
+
+	int i, j, value;
+
+	defsTab();
+	if (linker)
+		scriptTab();
+
+	poeTexto("<svg x=");
+	poeInt(x);
+	poeTexto(" y=");
+	poeInt(y);
+	poeTexto(" width=");
+	poeInt(getE_cols(state) * size);
+	poeTexto(" height=");
+	poeInt(getE_lins(state) * size);
+	poeTexto(" viewBox='0 0 ");
+	poeInt(getE_cols(state));
+	poeTexto(" ");
+	poeInt(getE_lins(state));
+	poeTexto("'");
+	if (linker){
+		poeTexto(" data-l='http://localhost/cgi-bin/GandaGalo?");
+		poeTexto(getE_user(state));
+		poeTexto("/'");
+	}
+	poeTexto(">\n");
 
 	for (i = 0; i < getE_lins(state); ++i){
 		for (j = 0; j < getE_cols(state); ++j){
-			//puts("4");
-			sprintf(buffer,"http://localhost/cgi-bin/GandaGalo?%s/@l%dc%d/",getE_user(state),i,j);
-			putimage(x,y,j,i,size,getE_elem(state,i,j),buffer, getE_menu(state), getE_menu(state)==0 || getE_menu(state)==1);
+			value = getE_elem(state,i,j);
+			//as peças fixas só são clicavéis quando se desenha o mapa
+			putimage(j, i, value, linker && menu && (value == BLOQUEADA || value == FIXO_X || value == FIXO_O));
 		}
 	}
 
+	poeTexto("</svg>\n");
 }
 
 /**
@@ -150,5 +212,34 @@ void mapPlacer (int x, int y, int size, int id, ESTADO state, char * username)
 
 	    drawTab(state, size, x, y);
 
+	FECHAR_LINK;
+}
+
+/**
+\brief Função que coloca a miniatura já desenhada de um mapa pré-definido, clicavél
+
+A miniatura foi desenhada com o tamanho @c MINIATURA a partir da origem, sendo deslocada e escalada.
+
+@param x abcissa do canto superior esquerdo do mapa
+@param y ordenada do canto superior esquerdo do mapa
+@param size tamanho do mapa
+@param id número do mapa que está a ser desenhado
+@param svg fragmento SVG da miniatura
+@param tam tamanho do fragmento
+@param username o nome do utilizador que está a jogar
+*/
+void miniaturaPlacer (int x, int y, int size, int id, const char * svg, size_t tam, char * username)
+{
+	char s[MAX_BUFFER];
+
+	sprintf(s,"http://localhost/cgi-bin/GandaGalo?%s/$%d",username, id);
+
+	defsTab();
+	ABRIR_LINK(s);
+
+	    poeFormato("<g transform=\"translate(%d,%d) scale(%g)\">\n", x, y, (double)size / MINIATURA);
+	    poeBytes(svg, tam);
+	    poeTexto("</g>\n");
+
 	FECHAR_LINK;
 }
\ No newline at end of file
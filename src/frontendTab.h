@@ -7,8 +7,12 @@
 
 // ------------------------------------------------------------------------------
 
+void defsTab ();
+
 void drawTab (ESTADO state,int windowsize, int x, int y);
 
 void mapPlacer (int x, int y, int size, int id, ESTADO state, char * username);
 
+void miniaturaPlacer (int x, int y, int size, int id, const char * svg, size_t tam, char * username);
+
 #endif
\ No newline at end of file
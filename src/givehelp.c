@@ -81,8 +81,8 @@ Se existirem duas pecas em linha ela coloca uma peça válida numa das extremida
 @see possiblepath
 @see playadvance
 @see formove
-@see push
-@see getE_stack
+@see jogada
+@see getE_hist
 */
 static int putnatural(ESTADO src, ESTADO comp)
 {
@@ -102,7 +102,7 @@ static int putnatural(ESTADO src, ESTADO comp)
 
 				if (newElem == getE_elem(comp, i, j))
 				{
-					push(getE_stack(src, 0), i, j, oldElem);
+					jogada(getE_hist(src), i, j, oldElem, newElem);
 					found = 1;
 				}
 				else
@@ -122,7 +122,7 @@ A função percorre ambos os estados, sendo que @p comp deve corresponder à sol
 é igual à peça que se encontra na mesma posição na solução, caso sejam iguais as peças nenhuma operação é efetuada.
 Caso contrário, o elemento em questão é alterada para a peça correspondente na solução. O que gera três casos:
 
-- A nova peça é válida, então o elemento é alterado, e colocado na @b STACK .
+- A nova peça é válida, então o elemento é alterado, e registado na @b HISTORIA .
 - A nova peça é inválida e @p indc é @b 0 , então a peça será alterada para o elemento antigo que lá se encontrava.
 - A nova peça é inválida e @p indc é diferente de @b 0 , então é utilizada recursividade de forma a alterar um número arbitrário de peças até que o tabuleiro se torne válido.
 .
@@ -134,8 +134,8 @@ Caso contrário, o elemento em questão é alterada para a peça correspondente
 @returns 0 se encontrou uma peça para alterar, 1 caso contrário.
 
 @see is_solto
-@see push
-@see getE_stack
+@see jogada
+@see getE_hist
 */
 static int searchcomp(ESTADO src, ESTADO comp, int indc)
 {
@@ -155,7 +155,7 @@ static int searchcomp(ESTADO src, ESTADO comp, int indc)
 
 				if (valtab(src, i, j))
 				{
-					push(getE_stack(src, 0), i, j, oldElem);
+					jogada(getE_hist(src), i, j, oldElem, newElem);
 					found = 1;
 				}
 				else{
@@ -182,6 +182,7 @@ nenhum elemento a alterar desta forma então corre a função @c searchcomp com
 @param e Estado a alterar.
 
 @see getE_help
+@see snapshotState
 @see solve
 @see putnatural
 @see searchcomp
@@ -193,7 +194,7 @@ void givehelp(ESTADO e)
 	n_helps = getE_help(e);
 
 	if (n_helps > 0){
-		ESTADO comp = makeState(e);
+		ESTADO comp = snapshotState(e);
 		solve(comp, &trash);
 
 		if (!putnatural(e, comp))
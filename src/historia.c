@@ -0,0 +1,1019 @@
+/**
+*@file historia.c
+\brief Módulo para operar sobre a HISTORIA de jogadas.
+*/
+#include "historia.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ------------------------------------------------------------------------------
+
+/* Métodos públicos */
+HISTORIA initH();
+void destroyH(HISTORIA h);
+void jogada(HISTORIA h, int i, int j, char velho, char novo);
+int recuar(HISTORIA h, int *i, int *j, char *val);
+int avancar(HISTORIA h, int *i, int *j, char *val);
+void apontar(HISTORIA h, int destino, int *sobe, int *desce);
+int nRamos(HISTORIA h);
+void outroRamo(HISTORIA h);
+int addNo(HISTORIA h, int pai, int i, int j, char velho, char novo);
+int setH_atual(HISTORIA h, int atual, int fim);
+int getH_atual(HISTORIA h);
+int getH_fim(HISTORIA h);
+int nNos(HISTORIA h);
+int makeAnc(HISTORIA h, char *nome);
+int findAnc(HISTORIA h, char *nome);
+void removeAnc(HISTORIA h, int k);
+int nAnc(HISTORIA h);
+int getAnc_no(HISTORIA h, int k);
+char *getAnc_nome(HISTORIA h, int k);
+void clearAnc(HISTORIA h);
+void addAnc(HISTORIA h, int no, const char *nome);
+void writeNos(HISTORIA h, FILE *fp);
+void writeAnc(HISTORIA h, FILE *fp);
+size_t tamH(int nnos, int nanc);
+void copiaH(HISTORIA h, char *buf);
+HISTORIA lerH(const char *buf, int nnos, int nanc, int atual);
+HISTORIA lerAdiadoH(int nnos, int nanc, int atual, const char *anc, LEITOR ler, void *ctx);
+void marcaH(HISTORIA h);
+int mudouH(HISTORIA h);
+size_t tamDeltaH(HISTORIA h);
+void copiaDeltaH(HISTORIA h, char *buf);
+int aplicaDeltaH(HISTORIA h, const char *buf, size_t tam);
+
+/* Métodos privados */
+static void crescer(HISTORIA h);
+static void crescerAnc(HISTORIA h);
+static void mudaSeguinte(HISTORIA h, int no, int s);
+static void ligaNo(HISTORIA h, int k);
+static void carregaBloco(HISTORIA h, int b);
+static void carregaTodos(HISTORIA h);
+static struct no *obterNo(HISTORIA h, int k);
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Capacidade inicial do array de nós de uma @c HISTORIA .
+*/
+#define HISTORIA_INICIAL 16
+
+/**
+\brief Número de nós lidos de cada vez de uma @c HISTORIA criada com @c lerAdiadoH .
+*/
+#define NOS_BLOCO 256
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Estrutura para um nó da árvore de jogadas.
+
+Cada nó corresponde a uma jogada feita a partir do nó pai, guardando o valor da
+posição antes e depois da jogada. Depois de criado, só o redo e o primeiro filho de um nó mudam.
+Os filhos de um nó formam uma lista, do mais recente para o mais antigo, pelo que contar
+ou percorrer os ramos de um nó só passa pelos seus filhos.
+*/
+typedef struct no
+{
+    int pai;             /**< nó anterior à jogada, -1 na raiz*/
+    int prof;            /**< número de jogadas desde a raiz*/
+    int seguinte;        /**< filho seguido por um redo, -1 se não existir*/
+    int filho;           /**< filho mais recente, -1 se não existir*/
+    int irmao;           /**< filho do mesmo pai criado antes deste, -1 se não existir*/
+    unsigned char i;     /**< abcissa da jogada*/
+    unsigned char j;     /**< ordenada da jogada*/
+    unsigned char velho; /**< valor antes da jogada*/
+    unsigned char novo;  /**< valor depois da jogada*/
+} NO;
+
+/**
+\brief Estrutura para uma âncora.
+*/
+typedef struct ancora
+{
+    int no;                     /**< nó ancorado*/
+    char nome[MAX_ANC_NOME];    /**< nome da âncora, vazio se não tiver nome*/
+} ANCORA;
+
+/**
+\brief Estrutura para uma alteração do redo de um nó já existente quando a história foi marcada.
+*/
+typedef struct mudanca
+{
+    int no;       /**< nó alterado*/
+    int seguinte; /**< novo valor do redo do nó*/
+} MUDANCA;
+
+/**
+\brief Cabeçalho da forma binária das alterações feitas a uma @c HISTORIA desde que foi marcada.
+
+É seguido pelos nós novos, pelas alterações de redo e, se tiverem mudado, por todas as âncoras.
+Os valores são absolutos, pelo que aplicar de novo alterações já aplicadas não muda a história.
+*/
+typedef struct delta
+{
+    int reinicio;  /**< 1 se a história foi substituida e deve ser recomeçada a partir da raiz*/
+    int primeiro;  /**< número do primeiro nó novo*/
+    int nnos;      /**< número de nós novos*/
+    int nmud;      /**< número de alterações de redo*/
+    int atual;     /**< nó atual*/
+    int nanc;      /**< número de âncoras, -1 se não mudaram*/
+} DELTA;
+
+/**
+\brief Declaração da Estrutura principal
+
+A história é uma árvore de jogadas guardada num array contíguo, onde os nós só são acrescentados.
+O nó 0 é a raiz e corresponde ao tabuleiro antes de qualquer jogada. Uma jogada feita depois de
+um undo cria um novo ramo, pelo que os ramos partilham o prefixo comum e nenhum é perdido.
+
+Os nós no caminho da raiz até ao nó atual têm sempre o campo @c seguinte a apontar para esse caminho,
+pelo que um undo não precisa de o alterar.
+*/
+typedef struct historia
+{
+    int n;        /**< número de nós*/
+    int cap;      /**< capacidade do array de nós*/
+    NO *v;        /**< nós da árvore, cada nó depois do seu pai*/
+    int atual;    /**< nó correspondente ao tabuleiro atual*/
+    int nanc;     /**< número de âncoras*/
+    int capanc;   /**< capacidade do array de âncoras*/
+    ANCORA *anc;  /**< âncoras, da mais antiga para a mais recente*/
+    int marca;    /**< número de nós quando a história foi marcada, 0 se nunca foi marcada*/
+    int atualMarca; /**< nó atual quando a história foi marcada*/
+    int ancMudou; /**< 1 se as âncoras mudaram desde a marca*/
+    int nmud;     /**< número de alterações de redo desde a marca*/
+    int capmud;   /**< capacidade do array de alterações*/
+    MUDANCA *mud; /**< alterações de redo dos nós anteriores à marca*/
+    int base;     /**< número de nós que ainda estão na fonte, e só são lidos quando são precisos*/
+    unsigned char *blocos; /**< indica, para cada bloco de @c NOS_BLOCO nós abaixo de @c base, se já foi lido*/
+    LEITOR ler;   /**< função que lê os nós da fonte*/
+    void *ctx;    /**< contexto de @c ler, libertado com a história*/
+} * HISTORIA;
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Garante que existe espaço para mais um nó, duplicando a capacidade se necessário.
+
+@param h @c HISTORIA a alterar.
+*/
+static void crescer(HISTORIA h)
+{
+    if (h->n < h->cap)
+        return;
+    h->cap *= 2;
+    h->v = realloc(h->v, sizeof(NO) * h->cap);
+}
+
+/**
+\brief Garante que existe espaço para mais uma âncora.
+
+@param h @c HISTORIA a alterar.
+*/
+static void crescerAnc(HISTORIA h)
+{
+    if (h->nanc < h->capanc)
+        return;
+    h->capanc = h->capanc ? h->capanc * 2 : 4;
+    h->anc = realloc(h->anc, sizeof(ANCORA) * h->capanc);
+}
+
+/**
+\brief Lê da fonte um bloco de nós, verificando-os de forma a que uma fonte corrompida
+não leve a acessos fora do array.
+
+@param h @c HISTORIA a alterar.
+@param b Número do bloco.
+*/
+static void carregaBloco(HISTORIA h, int b)
+{
+    int k, ini = b * NOS_BLOCO, fim = (ini + NOS_BLOCO < h->base) ? ini + NOS_BLOCO : h->base;
+    NO *x;
+    h->blocos[b] = 1;
+    if (h->ler(h->ctx, sizeof(NO) * ini, sizeof(NO) * (fim - ini), (char *)&(h->v[ini])))
+        memset(&(h->v[ini]), 0, sizeof(NO) * (fim - ini));
+    for (k = ini; k < fim; k++)
+    {
+        x = &(h->v[k]);
+        if (k == 0)
+            x->pai = -1;
+        else if (x->pai < 0 || x->pai >= k)
+            x->pai = 0;
+        if (x->seguinte <= k || x->seguinte >= h->base)
+            x->seguinte = -1;
+        if (x->filho <= k || x->filho >= h->base)
+            x->filho = -1;
+        if (x->irmao <= x->pai || x->irmao >= k)
+            x->irmao = -1;
+    }
+}
+
+/**
+\brief Lê da fonte todos os nós que ainda não foram lidos.
+
+@param h @c HISTORIA a alterar.
+*/
+static void carregaTodos(HISTORIA h)
+{
+    int b;
+    for (b = 0; b * NOS_BLOCO < h->base; b++)
+        if (!h->blocos[b])
+            carregaBloco(h, b);
+}
+
+/**
+\brief Obtem um nó, lendo-o da fonte caso ainda não tenha sido lido.
+
+@param h @c HISTORIA a consultar.
+@param k Número do nó.
+
+@returns O nó.
+*/
+static NO *obterNo(HISTORIA h, int k)
+{
+    if (k < h->base && !h->blocos[k / NOS_BLOCO])
+        carregaBloco(h, k / NOS_BLOCO);
+    return &(h->v[k]);
+}
+
+/**
+\brief Altera o redo de um nó, registando a alteração se o nó for anterior à marca.
+
+@param h @c HISTORIA a alterar.
+@param no Nó a alterar.
+@param s Novo redo do nó.
+*/
+static void mudaSeguinte(HISTORIA h, int no, int s)
+{
+    MUDANCA *m;
+    obterNo(h, no)->seguinte = s;
+    if (no >= h->marca)
+        return;
+    if (h->nmud == h->capmud)
+    {
+        h->capmud = h->capmud ? h->capmud * 2 : 8;
+        h->mud = realloc(h->mud, sizeof(MUDANCA) * h->capmud);
+    }
+    m = &(h->mud[h->nmud++]);
+    m->no = no;
+    m->seguinte = s;
+}
+
+/**
+\brief Acrescenta um nó acabado de criar à lista de filhos do seu pai.
+
+@param h @c HISTORIA a alterar.
+@param k Nó a ligar, que deve ser o último.
+*/
+static void ligaNo(HISTORIA h, int k)
+{
+    NO *x = &(h->v[k]), *p = obterNo(h, x->pai);
+    x->filho = -1;
+    x->irmao = p->filho;
+    p->filho = k;
+}
+
+// ------------------------------------------------------------------------------
+
+/* Construtores */
+/**
+\brief
+    Cria uma instância deste módulo, contendo apenas a raiz.
+@returns @c HISTORIA criada.
+*/
+HISTORIA initH()
+{
+    HISTORIA h = (HISTORIA)malloc(sizeof(struct historia));
+    h->n = 1;
+    h->cap = HISTORIA_INICIAL;
+    h->v = (NO *)malloc(sizeof(NO) * h->cap);
+    memset(&(h->v[0]), 0, sizeof(NO));
+    h->v[0].pai = -1;
+    h->v[0].seguinte = -1;
+    h->v[0].filho = -1;
+    h->v[0].irmao = -1;
+    h->atual = 0;
+    h->nanc = 0;
+    h->capanc = 0;
+    h->anc = NULL;
+    h->marca = h->atualMarca = h->ancMudou = 0;
+    h->nmud = h->capmud = 0;
+    h->mud = NULL;
+    h->base = 0;
+    h->blocos = NULL;
+    h->ler = NULL;
+    h->ctx = NULL;
+    return h;
+}
+
+/**
+\brief
+    Destrói uma instância deste módulo.
+    @param h Instância de @c HISTORIA a ser destruida.
+*/
+void destroyH(HISTORIA h)
+{
+    free(h->v);
+    free(h->anc);
+    free(h->mud);
+    free(h->blocos);
+    free(h->ctx);
+    free(h);
+}
+
+/* Operações */
+/**
+\brief
+    Regista uma jogada feita a partir do nó atual.
+    Se o redo do nó atual corresponder à mesma jogada, esse nó é reutilizado, caso contrário é criado um novo ramo.
+    @param h @c HISTORIA a alterar.
+    @param i abcissa da jogada.
+    @param j ordenada da jogada.
+    @param velho valor da posição antes da jogada.
+    @param novo valor da posição depois da jogada.
+*/
+void jogada(HISTORIA h, int i, int j, char velho, char novo)
+{
+    int s = obterNo(h, h->atual)->seguinte;
+    NO *x = (s >= 0) ? obterNo(h, s) : NULL;
+    if (x && x->i == i && x->j == j && x->velho == velho && x->novo == novo)
+        h->atual = s;
+    else
+        h->atual = addNo(h, h->atual, i, j, velho, novo);
+}
+
+/**
+\brief
+    Volta ao nó pai do nó atual.
+    @param h @c HISTORIA a alterar.
+    @param i abcissa da jogada desfeita.
+    @param j ordenada da jogada desfeita.
+    @param val valor a repor na posição.
+
+    @returns 1 se existia uma jogada para desfazer, 0 caso contrário.
+*/
+int recuar(HISTORIA h, int *i, int *j, char *val)
+{
+    NO *x = obterNo(h, h->atual);
+    if (h->atual == 0)
+        return 0;
+    *i = x->i;
+    *j = x->j;
+    *val = x->velho;
+    h->atual = x->pai;
+    return 1;
+}
+
+/**
+\brief
+    Avança para o filho do nó atual indicado pelo redo.
+    @param h @c HISTORIA a alterar.
+    @param i abcissa da jogada refeita.
+    @param j ordenada da jogada refeita.
+    @param val valor a colocar na posição.
+
+    @returns 1 se existia uma jogada para refazer, 0 caso contrário.
+*/
+int avancar(HISTORIA h, int *i, int *j, char *val)
+{
+    int s = obterNo(h, h->atual)->seguinte;
+    NO *x;
+    if (s < 0)
+        return 0;
+    x = obterNo(h, s);
+    *i = x->i;
+    *j = x->j;
+    *val = x->novo;
+    h->atual = s;
+    return 1;
+}
+
+/**
+\brief
+    Prepara um salto do nó atual para outro nó da árvore.
+    É calculado o antecessor comum dos dois nós, e o redo dos nós entre este e o destino passa a
+    seguir o caminho para o destino. O salto é feito com @p sobe chamadas a @c recuar seguidas de
+    @p desce chamadas a @c avancar , em tempo proporcional à profundidade dos nós.
+    @param h @c HISTORIA a alterar.
+    @param destino Nó para onde se pretende saltar.
+    @param sobe Número de jogadas a desfazer.
+    @param desce Número de jogadas a refazer.
+
+    @see recuar
+    @see avancar
+*/
+void apontar(HISTORIA h, int destino, int *sobe, int *desce)
+{
+    int a = h->atual, b = destino;
+    *sobe = *desce = 0;
+    if (destino < 0 || destino >= h->n)
+        return;
+    while (a > 0 && obterNo(h, a)->prof > obterNo(h, b)->prof)
+    {
+        a = obterNo(h, a)->pai;
+        (*sobe)++;
+    }
+    while (a != b)
+    {
+        if (a > 0 && obterNo(h, a)->prof == obterNo(h, b)->prof)
+        {
+            a = obterNo(h, a)->pai;
+            (*sobe)++;
+        }
+        if (b == 0)
+            break;
+        mudaSeguinte(h, obterNo(h, b)->pai, b);
+        b = obterNo(h, b)->pai;
+        (*desce)++;
+    }
+}
+
+/**
+\brief
+    Conta os ramos que partem do nó atual.
+    Sem redo não há ramos por onde seguir, pelo que os filhos não são percorridos.
+    @param h @c HISTORIA a consultar.
+
+    @returns O número de filhos do nó atual.
+*/
+int nRamos(HISTORIA h)
+{
+    int k, r = 0;
+    NO *x = obterNo(h, h->atual);
+    if (x->seguinte < 0)
+        return 0;
+    for (k = x->filho; k >= 0; k = obterNo(h, k)->irmao)
+        r++;
+    return r;
+}
+
+/**
+\brief
+    Faz o redo do nó atual passar a seguir o ramo seguinte, voltando ao primeiro depois do último.
+    Os ramos seguem a ordem em que foram criados, e a lista de filhos está pela ordem inversa.
+    @param h @c HISTORIA a alterar.
+*/
+void outroRamo(HISTORIA h)
+{
+    NO *x = obterNo(h, h->atual);
+    int k, proximo = -1, primeiro = -1;
+    for (k = x->filho; k >= 0; k = obterNo(h, k)->irmao)
+    {
+        if (k > x->seguinte)
+            proximo = k;
+        primeiro = k;
+    }
+    mudaSeguinte(h, h->atual, proximo >= 0 ? proximo : primeiro);
+}
+
+/**
+\brief
+    Acrescenta um nó à árvore, que passa a ser o redo do seu pai.
+    @param h @c HISTORIA a alterar.
+    @param pai Nó a partir do qual é feita a jogada.
+    @param i abcissa da jogada.
+    @param j ordenada da jogada.
+    @param velho valor da posição antes da jogada.
+    @param novo valor da posição depois da jogada.
+
+    @returns O número do nó criado, ou -1 se o pai não existir.
+*/
+int addNo(HISTORIA h, int pai, int i, int j, char velho, char novo)
+{
+    NO *x;
+    if (pai < 0 || pai >= h->n)
+        return -1;
+    crescer(h);
+    x = &(h->v[h->n]);
+    x->pai = pai;
+    x->prof = obterNo(h, pai)->prof + 1;
+    x->seguinte = -1;
+    x->i = i;
+    x->j = j;
+    x->velho = velho;
+    x->novo = novo;
+    ligaNo(h, h->n);
+    mudaSeguinte(h, pai, h->n);
+    return h->n++;
+}
+
+/**
+\brief
+    Altera o nó atual e o fim da linha de redo.
+    @param h @c HISTORIA a alterar.
+    @param atual Novo nó atual.
+    @param fim Último nó alcançável por redo a partir de @p atual .
+
+    @returns 1 se os nós forem válidos, 0 caso contrário, ficando a raiz como nó atual.
+*/
+int setH_atual(HISTORIA h, int atual, int fim)
+{
+    int x;
+    if (atual < 0 || atual >= h->n || fim < 0 || fim >= h->n)
+    {
+        h->atual = 0;
+        return 0;
+    }
+    for (x = fim; x > atual; x = obterNo(h, x)->pai)
+        ;
+    if (x != atual)
+        fim = atual;
+    for (x = fim; x > 0; x = obterNo(h, x)->pai)
+        mudaSeguinte(h, obterNo(h, x)->pai, x);
+    mudaSeguinte(h, fim, -1);
+    h->atual = atual;
+    return 1;
+}
+
+/**
+\brief
+    Obtem o nó atual.
+    @param h @c HISTORIA a consultar.
+
+    @returns O nó atual.
+*/
+int getH_atual(HISTORIA h)
+{
+    return h->atual;
+}
+
+/**
+\brief
+    Obtem o último nó alcançável por redo a partir do nó atual.
+    @param h @c HISTORIA a consultar.
+
+    @returns O último nó da linha de redo.
+*/
+int getH_fim(HISTORIA h)
+{
+    int x = h->atual;
+    while (obterNo(h, x)->seguinte >= 0)
+        x = obterNo(h, x)->seguinte;
+    return x;
+}
+
+/**
+\brief
+    Indica o número de nós da árvore, incluindo a raiz.
+    @param h @c HISTORIA a consultar.
+
+    @returns O número de nós.
+*/
+int nNos(HISTORIA h)
+{
+    return h->n;
+}
+
+/**
+\brief
+    Coloca uma âncora no nó atual.
+    Uma âncora com nome substitui outra âncora com o mesmo nome.
+    @param h A @c HISTORIA onde irá ser guardada a âncora.
+    @param nome Nome da âncora, NULL ou vazio para uma âncora sem nome.
+
+    @returns Devolve 1.
+*/
+int makeAnc(HISTORIA h, char *nome)
+{
+    int k;
+    ANCORA *a;
+    if (nome == NULL)
+        nome = "";
+    if (nome[0] && (k = findAnc(h, nome)) >= 0)
+        removeAnc(h, k);
+    a = h->nanc ? &(h->anc[h->nanc - 1]) : NULL;
+    if (a == NULL || a->no != h->atual || strcmp(a->nome, nome))
+        addAnc(h, h->atual, nome);
+    return 1;
+}
+
+/**
+\brief
+    Procura a âncora mais recente com um dado nome.
+    A âncora mais recente é encontrada em tempo constante.
+    @param h @c HISTORIA a consultar.
+    @param nome Nome da âncora, se for NULL ou vazio é devolvida a âncora mais recente.
+
+    @returns A posição da âncora, ou -1 se não existir.
+*/
+int findAnc(HISTORIA h, char *nome)
+{
+    int k;
+    if (nome == NULL || nome[0] == '\0')
+        return h->nanc - 1;
+    for (k = h->nanc - 1; k >= 0; k--)
+        if (!strcmp(h->anc[k].nome, nome))
+            return k;
+    return -1;
+}
+
+/**
+\brief
+    Remove uma âncora.
+    @param h A @c HISTORIA de onde irá ser removida a âncora.
+    @param k Posição da âncora.
+*/
+void removeAnc(HISTORIA h, int k)
+{
+    if (k < 0 || k >= h->nanc)
+        return;
+    memmove(&(h->anc[k]), &(h->anc[k + 1]), sizeof(ANCORA) * (h->nanc - k - 1));
+    h->nanc--;
+    h->ancMudou = 1;
+}
+
+/**
+\brief
+    Indica o número de âncoras.
+    @param h A @c HISTORIA a consultar.
+
+    @returns O número de âncoras.
+*/
+int nAnc(HISTORIA h)
+{
+    return h->nanc;
+}
+
+/**
+\brief
+    Obtem o nó de uma âncora.
+    @param h A @c HISTORIA a consultar.
+    @param k Posição da âncora, sendo 0 a mais antiga.
+
+    @returns O nó ancorado.
+*/
+int getAnc_no(HISTORIA h, int k)
+{
+    return h->anc[k].no;
+}
+
+/**
+\brief
+    Obtem o nome de uma âncora.
+    @param h A @c HISTORIA a consultar.
+    @param k Posição da âncora, sendo 0 a mais antiga.
+
+    @returns O nome da âncora, vazio se não tiver nome.
+*/
+char *getAnc_nome(HISTORIA h, int k)
+{
+    return h->anc[k].nome;
+}
+
+/**
+\brief
+    Remove todas as âncoras.
+    @param h A @c HISTORIA a alterar.
+*/
+void clearAnc(HISTORIA h)
+{
+    h->nanc = 0;
+    h->ancMudou = 1;
+}
+
+/**
+\brief
+    Acrescenta uma âncora como a mais recente.
+    @param h A @c HISTORIA a alterar.
+    @param no Nó a ancorar, ignorado se não existir.
+    @param nome Nome da âncora, NULL ou vazio para uma âncora sem nome.
+*/
+void addAnc(HISTORIA h, int no, const char *nome)
+{
+    ANCORA *a;
+    if (no < 0 || no >= h->n)
+        return;
+    crescerAnc(h);
+    a = &(h->anc[h->nanc++]);
+    h->ancMudou = 1;
+    a->no = no;
+    strncpy(a->nome, nome ? nome : "", MAX_ANC_NOME - 1);
+    a->nome[MAX_ANC_NOME - 1] = '\0';
+}
+
+/**
+\brief Escreve os nós de uma @c HISTORIA num ficheiro, por ordem de criação, sem a raiz.
+
+Cada nó é escrito como @b (i,j,velho,novo) quando o pai é o nó anterior, ou como
+@b (i,j,velho,novo,d) quando o pai se encontra @b d nós atrás.
+
+@param h A @c HISTORIA a escrever.
+@param fp Ficheiro onde serão escritos os nós.
+*/
+void writeNos(HISTORIA h, FILE *fp)
+{
+    int k;
+    NO *x;
+    carregaTodos(h);
+    for (k = 1; k < h->n; k++)
+    {
+        x = &(h->v[k]);
+        if (x->pai == k - 1)
+            fprintf(fp, " (%d,%d,%d,%d)", x->i, x->j, x->velho, x->novo);
+        else
+            fprintf(fp, " (%d,%d,%d,%d,%d)", x->i, x->j, x->velho, x->novo, k - x->pai);
+    }
+}
+
+/**
+\brief Escreve as âncoras de uma @c HISTORIA num ficheiro, da mais antiga para a mais recente.
+
+Cada âncora é escrita como o nó ancorado e o seu nome, sendo @b - usado para âncoras sem nome.
+
+@param h A @c HISTORIA cujas âncoras serão escritas.
+@param fp Ficheiro onde serão escritas as âncoras.
+*/
+void writeAnc(HISTORIA h, FILE *fp)
+{
+    int k;
+    for (k = 0; k < h->nanc; k++)
+        fprintf(fp, " (%d,%s)", h->anc[k].no, h->anc[k].nome[0] ? h->anc[k].nome : "-");
+}
+
+/**
+\brief Indica o tamanho, em bytes, da forma binária de uma @c HISTORIA .
+
+@param nnos Número de nós, incluindo a raiz.
+@param nanc Número de âncoras.
+
+@returns O tamanho da forma binária.
+
+@see copiaH
+*/
+size_t tamH(int nnos, int nanc)
+{
+    return sizeof(NO) * nnos + sizeof(ANCORA) * nanc;
+}
+
+/**
+\brief Copia a forma binária de uma @c HISTORIA para um buffer.
+
+A forma binária são os arrays de nós e de âncoras, copiados tal como estão em memória,
+pelo que pode ser lida de volta sem qualquer interpretação.
+
+@param h A @c HISTORIA a copiar.
+@param buf Buffer com pelo menos @c tamH bytes.
+
+@see tamH
+@see lerH
+*/
+void copiaH(HISTORIA h, char *buf)
+{
+    carregaTodos(h);
+    memcpy(buf, h->v, sizeof(NO) * h->n);
+    if (h->nanc)
+        memcpy(buf + sizeof(NO) * h->n, h->anc, sizeof(ANCORA) * h->nanc);
+}
+
+/**
+\brief Cria uma @c HISTORIA a partir da sua forma binária.
+
+Os nós são apenas verificados, de forma a que um ficheiro corrompido não leve a acessos fora do array.
+
+@param buf Buffer com a forma binária, escrita por @c copiaH .
+@param nnos Número de nós, incluindo a raiz.
+@param nanc Número de âncoras.
+@param atual Nó atual.
+
+@returns A @c HISTORIA criada, ou NULL se a forma binária for inválida.
+
+@see copiaH
+*/
+HISTORIA lerH(const char *buf, int nnos, int nanc, int atual)
+{
+    HISTORIA h;
+    int k;
+    const NO *v = (const NO *)buf;
+    if (nnos < 1 || nanc < 0 || atual < 0 || atual >= nnos || v[0].pai != -1)
+        return NULL;
+    for (k = 0; k < nnos; k++)
+        if ((k > 0 && (v[k].pai < 0 || v[k].pai >= k)) ||
+            (v[k].seguinte != -1 && (v[k].seguinte <= k || v[k].seguinte >= nnos)) ||
+            (v[k].filho != -1 && (v[k].filho <= k || v[k].filho >= nnos)) ||
+            (v[k].irmao != -1 && (v[k].irmao <= v[k].pai || v[k].irmao >= k)))
+            return NULL;
+    h = (HISTORIA)malloc(sizeof(struct historia));
+    h->n = nnos;
+    h->cap = nnos > HISTORIA_INICIAL ? nnos : HISTORIA_INICIAL;
+    h->v = (NO *)malloc(sizeof(NO) * h->cap);
+    memcpy(h->v, buf, sizeof(NO) * nnos);
+    h->atual = atual;
+    h->nanc = h->capanc = nanc;
+    h->marca = h->atualMarca = h->ancMudou = 0;
+    h->nmud = h->capmud = 0;
+    h->mud = NULL;
+    h->base = 0;
+    h->blocos = NULL;
+    h->ler = NULL;
+    h->ctx = NULL;
+    h->anc = NULL;
+    if (nanc)
+    {
+        h->anc = (ANCORA *)malloc(sizeof(ANCORA) * nanc);
+        memcpy(h->anc, buf + sizeof(NO) * nnos, sizeof(ANCORA) * nanc);
+    }
+    for (k = 0; k < nanc; k++)
+        if (h->anc[k].no < 0 || h->anc[k].no >= nnos)
+            h->anc[k].no = 0;
+    return h;
+}
+
+/**
+\brief Cria uma @c HISTORIA cujos nós ficam na fonte, sendo lidos em blocos só quando são precisos.
+
+Desta forma, o custo de uma jogada, de um undo ou de um redo não depende do número de nós da história.
+Cada bloco é verificado quando é lido, de forma a que uma fonte corrompida não leve a acessos fora do array.
+
+@param nnos Número de nós, incluindo a raiz.
+@param nanc Número de âncoras.
+@param atual Nó atual.
+@param anc Buffer com as âncoras, na forma escrita por @c copiaH .
+@param ler Função que lê parte da forma binária dos nós, escrita por @c copiaH .
+@param ctx Contexto passado a @p ler , que passa a pertencer à história e é libertado com @c free .
+
+@returns A @c HISTORIA criada, ou NULL se os valores forem inválidos.
+
+@see lerH
+*/
+HISTORIA lerAdiadoH(int nnos, int nanc, int atual, const char *anc, LEITOR ler, void *ctx)
+{
+    HISTORIA h;
+    int k;
+    if (nnos < 1 || nanc < 0 || atual < 0 || atual >= nnos)
+    {
+        free(ctx);
+        return NULL;
+    }
+    h = (HISTORIA)malloc(sizeof(struct historia));
+    h->n = h->base = nnos;
+    h->cap = 2 * nnos > HISTORIA_INICIAL ? 2 * nnos : HISTORIA_INICIAL;
+    h->v = (NO *)malloc(sizeof(NO) * h->cap);
+    h->blocos = calloc((nnos + NOS_BLOCO - 1) / NOS_BLOCO, 1);
+    h->ler = ler;
+    h->ctx = ctx;
+    h->atual = atual;
+    h->nanc = h->capanc = nanc;
+    h->marca = h->atualMarca = h->ancMudou = 0;
+    h->nmud = h->capmud = 0;
+    h->mud = NULL;
+    h->anc = NULL;
+    if (nanc)
+    {
+        h->anc = (ANCORA *)malloc(sizeof(ANCORA) * nanc);
+        memcpy(h->anc, anc, sizeof(ANCORA) * nanc);
+    }
+    for (k = 0; k < nanc; k++)
+    {
+        if (h->anc[k].no < 0 || h->anc[k].no >= nnos)
+            h->anc[k].no = 0;
+        h->anc[k].nome[MAX_ANC_NOME - 1] = '\0';
+    }
+    return h;
+}
+
+/**
+\brief Marca a história, passando as alterações seguintes a ser registadas.
+
+@param h @c HISTORIA a marcar.
+
+@see copiaDeltaH
+*/
+void marcaH(HISTORIA h)
+{
+    h->marca = h->n;
+    h->atualMarca = h->atual;
+    h->ancMudou = 0;
+    h->nmud = 0;
+}
+
+/**
+\brief Verifica se a história mudou desde que foi marcada.
+
+@param h @c HISTORIA a verificar.
+
+@returns 1 se a história mudou ou nunca foi marcada, 0 caso contrário.
+*/
+int mudouH(HISTORIA h)
+{
+    return (h->marca == 0 || h->n > h->marca || h->nmud || h->atual != h->atualMarca || h->ancMudou);
+}
+
+/**
+\brief Indica o tamanho, em bytes, da forma binária das alterações desde a marca.
+
+@param h @c HISTORIA a consultar.
+
+@returns O tamanho da forma binária das alterações.
+
+@see copiaDeltaH
+*/
+size_t tamDeltaH(HISTORIA h)
+{
+    int primeiro = h->marca ? h->marca : 1;
+    int nanc = (h->marca == 0 || h->ancMudou) ? h->nanc : 0;
+    return sizeof(DELTA) + sizeof(NO) * (h->n - primeiro) + sizeof(MUDANCA) * h->nmud + sizeof(ANCORA) * nanc;
+}
+
+/**
+\brief Copia a forma binária das alterações desde a marca para um buffer.
+
+Se a história nunca foi marcada, as alterações correspondem à história completa.
+
+@param h A @c HISTORIA a copiar.
+@param buf Buffer com pelo menos @c tamDeltaH bytes.
+
+@see aplicaDeltaH
+*/
+void copiaDeltaH(HISTORIA h, char *buf)
+{
+    DELTA *d = (DELTA *)buf;
+    d->reinicio = (h->marca == 0);
+    d->primeiro = h->marca ? h->marca : 1;
+    d->nnos = h->n - d->primeiro;
+    d->nmud = d->reinicio ? 0 : h->nmud;
+    d->atual = h->atual;
+    d->nanc = (d->reinicio || h->ancMudou) ? h->nanc : -1;
+    buf += sizeof(DELTA);
+    if (d->primeiro < h->base)
+        carregaTodos(h);
+    memcpy(buf, &(h->v[d->primeiro]), sizeof(NO) * d->nnos);
+    buf += sizeof(NO) * d->nnos;
+    if (d->nmud)
+        memcpy(buf, h->mud, sizeof(MUDANCA) * d->nmud);
+    buf += sizeof(MUDANCA) * d->nmud;
+    if (d->nanc > 0)
+        memcpy(buf, h->anc, sizeof(ANCORA) * d->nanc);
+}
+
+/**
+\brief Aplica a uma @c HISTORIA alterações escritas por @c copiaDeltaH .
+
+Os nós novos que a história já tenha são ignorados, pelo que aplicar de novo alterações
+já incluídas na história não a altera. Os restantes são ligados ao seu pai pela ordem em que foram criados.
+
+@param h A @c HISTORIA a alterar.
+@param buf Buffer com a forma binária das alterações.
+@param tam Tamanho do buffer.
+
+@returns 1 se as alterações foram aplicadas, 0 se forem inválidas, ficando a história por alterar.
+
+@see copiaDeltaH
+*/
+int aplicaDeltaH(HISTORIA h, const char *buf, size_t tam)
+{
+    DELTA d;
+    const NO *v;
+    const MUDANCA *m;
+    const ANCORA *a;
+    int k, n, fim;
+    if (tam < sizeof(DELTA))
+        return 0;
+    memcpy(&d, buf, sizeof(DELTA));
+    if (d.primeiro < 1 || d.nnos < 0 || d.nmud < 0 || d.nanc < -1 ||
+        tam != tamH(d.nnos, d.nanc > 0 ? d.nanc : 0) + sizeof(DELTA) + sizeof(MUDANCA) * d.nmud)
+        return 0;
+    v = (const NO *)(buf + sizeof(DELTA));
+    m = (const MUDANCA *)(v + d.nnos);
+    a = (const ANCORA *)(m + d.nmud);
+
+    n = d.reinicio ? 1 : h->n;
+    fim = d.primeiro + d.nnos;
+    if (d.primeiro > n || d.atual < 0 || d.atual >= (fim > n ? fim : n))
+        return 0;
+    for (k = n - d.primeiro; k < d.nnos; k++)
+        if (v[k].pai < 0 || v[k].pai >= d.primeiro + k ||
+            (v[k].seguinte != -1 && (v[k].seguinte <= d.primeiro + k || v[k].seguinte >= fim)))
+            return 0;
+    if (fim < n)
+        fim = n;
+    for (k = 0; k < d.nmud; k++)
+        if (m[k].no < 0 || m[k].no >= fim || (m[k].seguinte != -1 && (m[k].seguinte <= m[k].no || m[k].seguinte >= fim)))
+            return 0;
+
+    if (d.reinicio)
+    {
+        obterNo(h, 0)->seguinte = -1;
+        obterNo(h, 0)->filho = -1;
+        h->n = 1;
+        if (h->base > 1)
+            h->base = 1;
+    }
+    for (k = h->n - d.primeiro; k < d.nnos; k++)
+    {
+        crescer(h);
+        h->v[h->n] = v[k];
+        ligaNo(h, h->n++);
+    }
+    for (k = 0; k < d.nmud; k++)
+        obterNo(h, m[k].no)->seguinte = m[k].seguinte;
+    h->atual = d.atual;
+    if (d.nanc >= 0)
+    {
+        h->nanc = 0;
+        for (k = 0; k < d.nanc; k++)
+            addAnc(h, a[k].no, a[k].nome);
+    }
+    return 1;
+}
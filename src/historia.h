@@ -0,0 +1,97 @@
+/**
+*@file historia.h
+\brief Módulo para operar sobre a HISTORIA de jogadas.
+*/
+#ifndef HISTORIA_H
+#define HISTORIA_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Declaração da Estrutura principal.
+*/
+typedef struct historia* HISTORIA;
+
+/**
+\brief Tamanho máximo do nome de uma âncora, incluindo o terminador.
+*/
+#define MAX_ANC_NOME 16
+
+/**
+\brief Função que lê parte da forma binária dos nós de uma @c HISTORIA criada com @c lerAdiadoH .
+
+Recebe o contexto, a posição e o número de bytes a ler, e o buffer onde os colocar,
+devolvendo 0 em caso de sucesso.
+*/
+typedef int (*LEITOR)(void *ctx, size_t off, size_t tam, char *buf);
+
+// ------------------------------------------------------------------------------
+
+HISTORIA initH ();
+
+void destroyH (HISTORIA h);
+
+void jogada (HISTORIA h, int i, int j, char velho, char novo);
+
+int recuar (HISTORIA h, int * i, int * j, char * val);
+
+int avancar (HISTORIA h, int * i, int * j, char * val);
+
+void apontar (HISTORIA h, int destino, int * sobe, int * desce);
+
+int nRamos (HISTORIA h);
+
+void outroRamo (HISTORIA h);
+
+int addNo (HISTORIA h, int pai, int i, int j, char velho, char novo);
+
+int setH_atual (HISTORIA h, int atual, int fim);
+
+int getH_atual (HISTORIA h);
+
+int getH_fim (HISTORIA h);
+
+int nNos (HISTORIA h);
+
+int makeAnc (HISTORIA h, char * nome);
+
+int findAnc (HISTORIA h, char * nome);
+
+void removeAnc (HISTORIA h, int k);
+
+int nAnc (HISTORIA h);
+
+int getAnc_no (HISTORIA h, int k);
+
+char * getAnc_nome (HISTORIA h, int k);
+
+void clearAnc (HISTORIA h);
+
+void addAnc (HISTORIA h, int no, const char * nome);
+
+void writeNos (HISTORIA h, FILE * fp);
+
+void writeAnc (HISTORIA h, FILE * fp);
+
+size_t tamH (int nnos, int nanc);
+
+void copiaH (HISTORIA h, char * buf);
+
+HISTORIA lerH (const char * buf, int nnos, int nanc, int atual);
+
+HISTORIA lerAdiadoH (int nnos, int nanc, int atual, const char * anc, LEITOR ler, void * ctx);
+
+void marcaH (HISTORIA h);
+
+int mudouH (HISTORIA h);
+
+size_t tamDeltaH (HISTORIA h);
+
+void copiaDeltaH (HISTORIA h, char * buf);
+
+int aplicaDeltaH (HISTORIA h, const char * buf, size_t tam);
+
+#endif
@@ -0,0 +1,384 @@
+/**
+@file importar.c
+\brief Ficheiro do importador de mapas em massa.
+
+Lê mapas na convenção dos docentes, de ficheiros, diretórias ou de uma lista de caminhos no
+stdin, e valida cada um com @c validTab , resolvendo-o para saber se tem solução e se esta é única.
+Os mapas são avaliados em paralelo por vários trabalhadores, que os vão buscando a uma fila
+limitada, enquanto o processo principal lê os caminhos. No fim é escrito um ficheiro de mapas,
+com os mapas aceites, e um relatório com o resultado de cada mapa, pela ordem em que foram lidos.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "filemanager.h"
+#include "solver.h"
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Número máximo de mapas à espera de um trabalhador.
+*/
+#define TAM_FILA 64
+
+/**
+\brief Número máximo de trabalhadores.
+*/
+#define MAX_TRABALHADORES 64
+
+/**
+\brief Mapa a importar, e o resultado da sua avaliação.
+*/
+typedef struct mapa
+{
+	char *path;           /**< Caminho do ficheiro do mapa */
+	int lins;             /**< Número de linhas */
+	int cols;             /**< Número de colunas */
+	long nsol;            /**< Número de soluções */
+	char *grelha;         /**< Linhas do mapa, na convenção dos docentes, ou NULL se o mapa for rejeitado */
+	const char *motivo;   /**< Motivo da rejeição, ou NULL se o mapa for aceite */
+} MAPA;
+
+/**
+\brief Fila limitada dos mapas por avaliar, partilhada pelos trabalhadores.
+*/
+typedef struct fila
+{
+	pthread_mutex_t tranca;   /**< Tranca da fila */
+	pthread_cond_t cheia;     /**< Sinalizada quando sai um mapa da fila */
+	pthread_cond_t vazia;     /**< Sinalizada quando entra um mapa na fila, ou esta é fechada */
+	MAPA *v[TAM_FILA];        /**< Mapas na fila, em anel */
+	int ini;                  /**< Posição do primeiro mapa */
+	int n;                    /**< Número de mapas na fila */
+	int fechada;              /**< Diferente de 0 quando não entram mais mapas */
+	int multiplas;            /**< Diferente de 0 para aceitar mapas com várias soluções */
+} *FILA;
+
+/**
+\brief Mapas lidos, pela ordem em que foram lidos.
+*/
+static MAPA **mapas = NULL;
+
+/**
+\brief Número de mapas lidos.
+*/
+static int nmapas = 0;
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Coloca um mapa na fila, esperando que haja lugar.
+
+@param f Fila.
+@param x Mapa.
+*/
+static void poe(FILA f, MAPA *x)
+{
+	pthread_mutex_lock(&f->tranca);
+	while (f->n == TAM_FILA)
+		pthread_cond_wait(&f->cheia, &f->tranca);
+	f->v[(f->ini + f->n++) % TAM_FILA] = x;
+	pthread_cond_signal(&f->vazia);
+	pthread_mutex_unlock(&f->tranca);
+}
+
+/**
+\brief Tira um mapa da fila, esperando que haja algum.
+
+@param f Fila.
+
+@returns O mapa, ou NULL caso a fila esteja vazia e fechada.
+*/
+static MAPA *tira(FILA f)
+{
+	MAPA *x = NULL;
+
+	pthread_mutex_lock(&f->tranca);
+	while (f->n == 0 && !f->fechada)
+		pthread_cond_wait(&f->vazia, &f->tranca);
+	if (f->n > 0)
+	{
+		x = f->v[f->ini];
+		f->ini = (f->ini + 1) % TAM_FILA;
+		f->n--;
+		pthread_cond_signal(&f->cheia);
+	}
+	pthread_mutex_unlock(&f->tranca);
+	return x;
+}
+
+/**
+\brief Fecha a fila, acordando os trabalhadores que estão à espera.
+
+@param f Fila.
+*/
+static void fecha(FILA f)
+{
+	pthread_mutex_lock(&f->tranca);
+	f->fechada = 1;
+	pthread_cond_broadcast(&f->vazia);
+	pthread_mutex_unlock(&f->tranca);
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Escreve as linhas de um mapa na convenção dos docentes.
+
+@param e Mapa.
+
+@returns As linhas, que devem ser libertadas com @c free .
+*/
+static char *texto(ESTADO e)
+{
+	static const char simbolo[] = {'#', 'X', 'O', '.', '.', '.'};
+	char *s = malloc(getE_lins(e) * (getE_cols(e) + 1) + 1), *p = s, val;
+	int i, j;
+
+	for (i = 0; i < getE_lins(e); i++)
+	{
+		for (j = 0; j < getE_cols(e); j++)
+		{
+			val = getE_elem(e, i, j);
+			*p++ = (val >= 0 && val <= SOL_O) ? simbolo[(int)val] : '#';
+		}
+		*p++ = '\n';
+	}
+	*p = '\0';
+	return s;
+}
+
+/**
+\brief Avalia um mapa: lê-o, valida-o com @c validTab , e resolve-o.
+
+@param x Mapa, onde é colocado o resultado.
+@param multiplas Diferente de 0 para aceitar mapas com várias soluções.
+*/
+static void avalia(MAPA *x, int multiplas)
+{
+	int flag;
+	ESTADO e = select_padrao("", x->path, &flag);
+
+	if (e == NULL)
+	{
+		x->motivo = "inválido";
+		return;
+	}
+	if (!flag)
+	{
+		x->motivo = "ilegível";
+		destroyState(e);
+		return;
+	}
+
+	x->lins = getE_lins(e);
+	x->cols = getE_cols(e);
+	x->grelha = texto(e);
+	e = solve(e, &x->nsol);
+	destroyState(e);
+
+	if (x->nsol <= 0)
+		x->motivo = "sem solução";
+	else if (x->nsol > 1 && !multiplas)
+		x->motivo = "várias soluções";
+	if (x->motivo)
+	{
+		free(x->grelha);
+		x->grelha = NULL;
+	}
+}
+
+/**
+\brief Trabalhador, que avalia os mapas da fila até esta ser fechada.
+
+@param arg Fila.
+*/
+static void *trabalhador(void *arg)
+{
+	FILA f = arg;
+	MAPA *x;
+
+	while ((x = tira(f)) != NULL)
+		avalia(x, f->multiplas);
+	return NULL;
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Lê o caminho de um mapa, guardando-o e colocando-o na fila.
+
+@param f Fila.
+@param path Caminho do ficheiro do mapa.
+*/
+static void submete(FILA f, const char *path)
+{
+	MAPA *x = calloc(1, sizeof(MAPA));
+
+	x->path = strdup(path);
+	mapas = realloc(mapas, sizeof(MAPA *) * (nmapas + 1));
+	mapas[nmapas++] = x;
+	poe(f, x);
+}
+
+/**
+\brief Lê os mapas de uma diretória, por ordem alfabética, ignorando os ficheiros escondidos.
+
+@param f Fila.
+@param dir Caminho da diretória.
+
+@returns 0 em caso de sucesso, -1 caso a diretória não possa ser lida.
+*/
+static int submeteDir(FILA f, const char *dir)
+{
+	struct dirent **nomes;
+	struct stat st;
+	char *path;
+	int k, n = scandir(dir, &nomes, NULL, alphasort);
+
+	if (n < 0)
+		return -1;
+	for (k = 0; k < n; k++)
+	{
+		path = malloc(strlen(dir) + strlen(nomes[k]->d_name) + 2);
+		sprintf(path, "%s/%s", dir, nomes[k]->d_name);
+		if (nomes[k]->d_name[0] != '.' && !stat(path, &st) && S_ISREG(st.st_mode))
+			submete(f, path);
+		free(path);
+		free(nomes[k]);
+	}
+	free(nomes);
+	return 0;
+}
+
+/**
+\brief Lê os caminhos dos mapas do stdin, um por linha.
+
+@param f Fila.
+*/
+static void submeteStdin(FILA f)
+{
+	char *linha = NULL;
+	size_t cap = 0;
+	ssize_t n;
+
+	while ((n = getline(&linha, &cap, stdin)) > 0)
+	{
+		while (n > 0 && (linha[n - 1] == '\n' || linha[n - 1] == '\r'))
+			linha[--n] = '\0';
+		if (n > 0)
+			submete(f, linha);
+	}
+	free(linha);
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Função main para importar mapas em massa.
+
+Uso: @b importar [-j trabalhadores] [-m] [-i id] [-o mapas] [-r relatório] caminho...
+
+Cada caminho é um ficheiro de mapa, uma diretória de mapas, ou @b - para ler os caminhos do stdin.
+Os mapas aceites são escritos, com IDs a partir de @b -i , no ficheiro @b -o , ou no stdout, que pode
+depois ser compilado com o compilador de mapas. O relatório é escrito em @b -r , ou no stderr.
+Por omissão só são aceites mapas com uma única solução, a não ser que seja dado @b -m .
+*/
+int main(int argc, char *argv[])
+{
+	struct fila f = {.tranca = PTHREAD_MUTEX_INITIALIZER, .cheia = PTHREAD_COND_INITIALIZER,
+					 .vazia = PTHREAD_COND_INITIALIZER};
+	pthread_t t[MAX_TRABALHADORES];
+	FILE *out = stdout, *rel = stderr;
+	struct stat st;
+	long nt = sysconf(_SC_NPROCESSORS_ONLN);
+	int k, opt, id = 1, aceites = 0, r = 0;
+
+	while ((opt = getopt(argc, argv, "j:mi:o:r:")) != -1)
+		switch (opt)
+		{
+		case 'j': nt = atol(optarg); break;
+		case 'm': f.multiplas = 1; break;
+		case 'i': id = atoi(optarg); break;
+		case 'o':
+			if ((out = fopen(optarg, "w")) == NULL)
+			{
+				perror(optarg);
+				return 1;
+			}
+			break;
+		case 'r':
+			if ((rel = fopen(optarg, "w")) == NULL)
+			{
+				perror(optarg);
+				return 1;
+			}
+			break;
+		default:
+			fprintf(stderr, "uso: %s [-j trabalhadores] [-m] [-i id] [-o mapas] [-r relatório] caminho...\n", argv[0]);
+			return 1;
+		}
+	if (optind >= argc)
+	{
+		fprintf(stderr, "uso: %s [-j trabalhadores] [-m] [-i id] [-o mapas] [-r relatório] caminho...\n", argv[0]);
+		return 1;
+	}
+	if (nt < 1)
+		nt = 1;
+	if (nt > MAX_TRABALHADORES)
+		nt = MAX_TRABALHADORES;
+
+	for (k = 0; k < nt; k++)
+		pthread_create(t + k, NULL, trabalhador, &f);
+
+	for (k = optind; k < argc; k++)
+	{
+		if (!strcmp(argv[k], "-"))
+			submeteStdin(&f);
+		else if (!stat(argv[k], &st) && S_ISDIR(st.st_mode))
+		{
+			if (submeteDir(&f, argv[k]))
+			{
+				perror(argv[k]);
+				r = 1;
+			}
+		}
+		else
+			submete(&f, argv[k]);
+	}
+
+	fecha(&f);
+	for (k = 0; k < nt; k++)
+		pthread_join(t[k], NULL);
+
+	for (k = 0; k < nmapas; k++)
+	{
+		if (mapas[k]->motivo)
+			fprintf(rel, "%s: rejeitado, %s\n", mapas[k]->path, mapas[k]->motivo);
+		else
+		{
+			fprintf(out, "::> %d\n%d %d\n%s\n", id, mapas[k]->lins, mapas[k]->cols, mapas[k]->grelha);
+			fprintf(rel, "%s: aceite como %d, %dx%d, %ld soluções\n",
+					mapas[k]->path, id++, mapas[k]->lins, mapas[k]->cols, mapas[k]->nsol);
+			aceites++;
+		}
+		free(mapas[k]->grelha);
+		free(mapas[k]->path);
+		free(mapas[k]);
+	}
+	free(mapas);
+	fprintf(rel, "%d de %d mapas aceites.\n", aceites, nmapas);
+
+	if (out != stdout && fclose(out))
+		r = 1;
+	if (rel != stderr)
+		fclose(rel);
+	return r;
+}
@@ -1,11 +1,30 @@
 /**
 @file leaderboard.c
 \brief Módulo de obtenção da leaderboard.
+
+A leaderboard é guardada no ficheiro binário @c FICHRANK , mapeado em memória, com os registos
+ordenados por número de vitórias e uma tabela de dispersão do nome do utilizador para a posição
+do seu registo. Atualizar um utilizador custa O(log n) por cada grupo de utilizadores com o mesmo
+número de vitórias que este ultrapassa, e obter os N primeiros custa O(N).
+
+Cada janela de tempo tem o seu ficheiro, com o mesmo formato, e o período a que este se refere.
+Cada vitória é somada ao ficheiro de cada janela, pelo que as leaderboards do mês, da semana e do
+dia custam o mesmo que a leaderboard total. Quando o período muda, o ficheiro é truncado no
+primeiro acesso para escrita, sem percorrer os registos.
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include "leaderboard.h"
 
 // ------------------------------------------------------------------------------
@@ -13,22 +32,54 @@
 /* Metódos públicos */
 char * getInfo_user (INFO v, int i);
 int getInfo_wins (INFO v, int i);
-int get_info (INFO * v, int N);
+int get_info (INFO * v, int janela, int ini, int N);
+int get_range (INFO * v, int janela, int from, int to);
+int get_rank (char * user, int janela, int * total);
 void push_info (char * user, int wins);
-
-/* Metódos privados */
-static void make_info ();
-static int size_info ();
-static INFO list_info (int * x);
-static int cmp_info (const void * a, const void * b);
-static void sort_info (INFO v);
+void win_info (char * user, int wins);
+int importa_info (char * ficheiro);
 
 // ------------------------------------------------------------------------------
 
 /**
-\brief Diretória onde se encontra o ficheiro onde são guardados todos os utilizadores.
+\brief Diretória onde se encontra o @c ARMAZEM onde são guardados todos os utilizadores.
+*/
+#define DIRUSERS "/usr/local/games/GandaGalo/users/"
+
+/**
+\brief Ficheiro de texto onde era guardada a leaderboard, antes do @c ARMAZEM .
+*/
+#define DIRINFO DIRUSERS "users.save"
+
+/**
+\brief Ficheiro binário onde é guardada a leaderboard.
+*/
+#define FICHRANK DIRUSERS "ranking.bin"
+
+/**
+\brief Ficheiros onde são guardadas as leaderboards de cada @c JANELA , com o formato de @c FICHRANK .
+*/
+static const char * const fichJanela[NJANELAS] = {
+	FICHRANK,
+	DIRUSERS "ranking-mes.bin",
+	DIRUSERS "ranking-semana.bin",
+	DIRUSERS "ranking-dia.bin"
+};
+
+/**
+\brief Identificador no início de @c FICHRANK .
+*/
+#define RANK_MAGIC "GGRK"
+
+/**
+\brief Versão do formato de @c FICHRANK .
+*/
+#define RANK_VERSAO 1
+
+/**
+\brief Número de registos para que há espaço num ficheiro novo. É sempre uma potência de 2.
 */
-#define DIRINFO "/usr/local/games/GandaGalo/users/users.save"
+#define RANK_CAP 64
 
 // ------------------------------------------------------------------------------
 
@@ -40,6 +91,57 @@ typedef struct info {
 	char user[MAX_S];	/**< Utilizador guardado. */
 } * INFO;
 
+/**
+\brief Cabeçalho de @c FICHRANK .
+
+Ao cabeçalho seguem-se @c cap registos de @c INFO , dos quais os @c n primeiros estão em uso,
+ordenados por número decrescente de vitórias, e a tabela de dispersão, com @c 2*cap posições,
+cada uma com a posição de um registo mais 1, ou 0 se estiver vazia.
+*/
+typedef struct ranking {
+	char magic[4];		/**< RANK_MAGIC */
+	int32_t versao;		/**< RANK_VERSAO */
+	int32_t n;			/**< Número de utilizadores */
+	int32_t cap;		/**< Número de registos para que há espaço */
+	int32_t periodo;	/**< Período da janela de tempo a que os registos se referem */
+} RANKING;
+
+/**
+\brief Ficheiro da leaderboard aberto e mapeado em memória.
+*/
+typedef struct tabela {
+	int fd;				/**< Descritor do ficheiro, que fica trancado enquanto está aberto */
+	size_t tam;			/**< Tamanho do ficheiro */
+	RANKING * r;		/**< Ficheiro mapeado em memória */
+	int n;				/**< Número de registos do período atual, 0 se o ficheiro for de um período anterior */
+} TABELA;
+
+/**
+\brief Registos de um @c RANKING mapeado em memória.
+*/
+#define REGS(r) ((INFO)((r) + 1))
+
+/**
+\brief Tabela de dispersão de um @c RANKING mapeado em memória.
+*/
+#define DISP(r) ((int32_t *)(REGS(r) + (r)->cap))
+
+/* Metódos privados */
+static size_t tamRanking (int cap);
+static int32_t periodo (int janela);
+static int abreRanking (TABELA * t, int janela, int escrita);
+static void fechaRanking (TABELA * t);
+static int mapeia (TABELA * t, size_t tam);
+static int esvazia (TABELA * t, int32_t periodo);
+static void refaz (RANKING * r, int cap);
+static int cresce (TABELA * t);
+static int32_t * procura (RANKING * r, char * user);
+static void troca (RANKING * r, int a, int b);
+static int corte (INFO v, int lo, int hi, int wins, int estrito);
+static void move (RANKING * r, int i, int wins);
+static void insere (TABELA * t, char * user, int wins);
+static void atualiza (int janela, char * user, int wins, int soma);
+
 // ------------------------------------------------------------------------------
 
 /**
@@ -69,144 +171,510 @@ int getInfo_wins (INFO v, int i){
 // ------------------------------------------------------------------------------
 
 /**
-\brief Função que verifica a existência de @c DIRINFO .
-Caso o ficheiro não exista, então é criado.
+\brief Função que adiciona nova informação à leaderboard.
+Consoante o utilizador e o número de vitória coloca em @c FICHRANK a informação passada
+como argumento. Da seguinte forma:
+
+- Se o utilizador não existir na leaderboard então é inserido na posição correspondente às suas vitórias.
+- Se o utilizador existir na leaderboard então o seu número de vitórias é atualizado, e o registo é movido.
+- Se o número de vitórias não mudou, nada é escrito.
 
-@see DIRINFO
+O ficheiro fica trancado durante a atualização, para que pedidos simultâneos não percam atualizações.
+Só é alterada a leaderboard total.
+
+@param user Utilizador em registo.
+@param wins Nome de vitórias em registo.
+
+@see atualiza
 */
-static void make_info ()
+void push_info (char * user, int wins)
 {
-	FILE * fp = fopen(DIRINFO,"r");
-	if (fp == NULL)
-		fp = fopen(DIRINFO,"w");
-	fclose(fp);
+	atualiza(JAN_TOTAL,user,wins,0);
 }
 
 /**
-\brief Função que adiciona nova informação ao ficheiro.
-Consoante o utilizador e o número de vitória coloca no ficheiro @c DIRINFO a informação passada 
-como argumento. Da seguinte forma:
+\brief Função que regista uma vitória nova de um utilizador em todas as leaderboards.
 
-- Se o utilizador não existir no ficheiro então é colocado no fim.
-- Se o utilizador existir no ficheiro então o seu número de vitórias é atualizado.
+A leaderboard total passa a ter o número de vitórias dado, e às leaderboards das outras
+janelas de tempo é somada uma vitória.
 
 @param user Utilizador em registo.
-@param wins Nome de vitórias em registo.
+@param wins Número total de vitórias do utilizador, já com a vitória nova.
 
-@see make_info
-@see DIRINFO
+@see atualiza
 */
-
-void push_info (char * user, int wins)
+void win_info (char * user, int wins)
 {
-	char user_read[MAX_S]; int tmp ;
+	int k;
+	atualiza(JAN_TOTAL,user,wins,0);
+	for (k = JAN_TOTAL + 1 ; k < NJANELAS ; k++)
+		atualiza(k,user,1,1);
+}
 
-	make_info();
-	FILE * fp = fopen(DIRINFO,"r+");
+/**
+\brief Passa para a leaderboard a leaderboard guardada no ficheiro de texto antigo.
 
-	while ((tmp = fscanf(fp,"%s",user_read) ) != EOF
-		&& !strstr(user_read,user))
-		;
-	if (tmp == EOF)
-		fprintf(fp, "%s %3d\n", user, wins);
-	else {
-		fprintf(fp, " %3d", wins);
+@param ficheiro Caminho do ficheiro de texto.
+
+@returns O número de utilizadores lidos, ou -1 caso o ficheiro não exista.
+
+@see push_info
+*/
+int importa_info (char * ficheiro)
+{
+	char user[MAX_S]; int wins, r = 0;
+	FILE * fp = fopen(ficheiro,"r");
+	if (fp == NULL)
+		return -1;
+	while (fscanf(fp,"%49s %d",user,&wins) == 2){
+		push_info(user,wins);
+		r++;
 	}
 	fclose(fp);
+	return r;
+}
+
+/**
+\brief Função que indica um array de @c INFO contendo parte da leaderboard.
+
+Como os registos já estão ordenados, são copiados apenas os pedidos, pelo que o custo não
+depende do número de utilizadores. Só podem ser vistas as primeiras @c TOP_K posições.
+
+@param v Apontador para o endereço onde irá ser colocada a leaderboard.
+@param janela @c JANELA de tempo da leaderboard.
+@param ini Primeira posição a colocar, a partir de 0.
+@param N Número máximo de elementos colocados.
+
+@returns Números de elementos colocados.
+
+@see INFO
+*/
+int get_info (INFO * v, int janela, int ini, int N)
+{
+	if (N > TOP_K - ini)
+		N = TOP_K - ini;
+	return get_range(v,janela,ini,ini + N);
 }
 
 /**
-\brief Função que devolve o número de elementos no ficheiro @c DIRINFO .
+\brief Função que indica um array de @c INFO com as posições da leaderboard num intervalo.
 
-@returns Devolve o número de elementos no ficheiro @c DIRINFO .
+Os registos estão ordenados por vitórias, pelo que a posição é o índice do registo,
+e o intervalo é copiado diretamente, sem ordenar os utilizadores.
 
-@see DIRINFO
+@param v Apontador para o endereço onde irão ser colocadas as posições.
+@param janela @c JANELA de tempo da leaderboard.
+@param from Primeira posição, a partir de 0.
+@param to Posição seguinte à última, exclusiva.
+
+@returns Números de elementos colocados.
 */
-static int size_info ()
+int get_range (INFO * v, int janela, int from, int to)
 {
-	int r = 0, dummy; char usr[MAX_S];
-	FILE * fp = fopen(DIRINFO,"r");
-	if (fp != NULL){
-		while (fscanf(fp,"%s %3d",usr,&dummy) != EOF)
-			r++;
+	TABELA t; int sz = 0;
+
+	*v = NULL;
+	if (from < 0 || to <= from || janela < 0 || janela >= NJANELAS || abreRanking(&t,janela,0))
+		return 0;
+	if (to > t.n)
+		to = t.n;
+	if ((sz = to - from) > 0){
+		*v = malloc(sizeof(struct info)*sz);
+		memcpy(*v,REGS(t.r) + from,sizeof(struct info)*sz);
 	}
+	fechaRanking(&t);
+	return (sz > 0) ? sz : 0;
+}
+
+/**
+\brief Função que indica a posição de um utilizador na leaderboard.
+
+O registo do utilizador é encontrado pela tabela de dispersão, e a posição é a do primeiro
+registo com o mesmo número de vitórias, encontrado por pesquisa binária, pelo que utilizadores
+empatados têm a mesma posição. O custo é O(log n).
+
+@param user Utilizador.
+@param janela @c JANELA de tempo da leaderboard.
+@param total Endereço onde é colocado o número de utilizadores da leaderboard, ou NULL.
+
+@returns A posição, a partir de 1, ou 0 caso o utilizador não esteja na leaderboard.
+
+@see procura
+@see corte
+*/
+int get_rank (char * user, int janela, int * total)
+{
+	TABELA t; int32_t * p; int r = 0;
+
+	if (total)
+		*total = 0;
+	if (janela < 0 || janela >= NJANELAS || abreRanking(&t,janela,0))
+		return 0;
+	if (total)
+		*total = t.n;
+	if (t.n && *(p = procura(t.r,user)))
+		r = corte(REGS(t.r),0,*p,REGS(t.r)[*p - 1].wins,0) + 1;
+	fechaRanking(&t);
 	return r;
-	fclose(fp);
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Tamanho de @c FICHRANK com espaço para um dado número de registos.
+
+@param cap Número de registos.
+
+@returns O tamanho, em bytes.
+*/
+static size_t tamRanking (int cap)
+{
+	return sizeof(RANKING) + sizeof(struct info)*cap + sizeof(int32_t)*2*cap;
 }
 
 /**
-\brief Cria um array com todos os elementos do ficheiro.
+\brief Período atual de uma janela de tempo.
+
+@param janela @c JANELA de tempo.
 
-@param x Endereço onde irá ser colocado o número de elementos lidos.
+@returns O número do dia, da semana ou do mês atual, contados desde 1970, ou 0 para @c JAN_TOTAL .
+As semanas começam à segunda-feira.
+*/
+static int32_t periodo (int janela)
+{
+	time_t t = time(NULL);
+	struct tm tm;
+
+	switch (janela){
+		case JAN_DIA:
+			return t / 86400;
+		case JAN_SEMANA:
+			return (t / 86400 + 3) / 7;
+		case JAN_MES:
+			gmtime_r(&t,&tm);
+			return (tm.tm_year - 70)*12 + tm.tm_mon;
+		default:
+			return 0;
+	}
+}
+
+/**
+\brief Abre e mapeia o ficheiro de uma janela de tempo, trancando-o até @c fechaRanking .
 
-@returns O array criado.
+Caso o ficheiro ainda não exista é criado, vazio. Caso tenha ficado a meio de crescer, a tabela
+de dispersão é refeita. Caso seja de um período anterior e seja aberto para escrita, é esvaziado,
+sem percorrer os registos.
 
-@see size_info
+@param t Onde é colocado o ficheiro aberto.
+@param janela @c JANELA de tempo.
+@param escrita Diferente de 0 para trancar o ficheiro para escrita.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
 */
-static INFO list_info (int * x)
+static int abreRanking (TABELA * t, int janela, int escrita)
 {
-	INFO r = NULL; FILE * fp;
-	int i, wins; char user[MAX_S];
-	*x = size_info();
-	if (*x){
-		fp = fopen(DIRINFO,"r");
-		r = malloc(sizeof(struct info)*(*x));
+	struct flock fl = {0};
+	struct stat st;
+	int32_t p = periodo(janela);
+	int cap;
+
+	if ((t->fd = open(fichJanela[janela],O_RDWR | O_CREAT,0660)) < 0)
+		return -1;
+	fl.l_whence = SEEK_SET;
+	fl.l_type = escrita ? F_WRLCK : F_RDLCK;
+	if (fcntl(t->fd,F_SETLKW,&fl) || fstat(t->fd,&st)){
+		close(t->fd);
+		return -1;
 	}
-	for (i = 0 ; i < *x ; i++){
-		if(fscanf(fp,"%s %3d",user,&wins) != EOF){
-			r[i].wins = wins;
-			strcpy(r[i].user,user);
+	if (!escrita && (size_t)st.st_size < sizeof(RANKING)){
+		fl.l_type = F_WRLCK;
+		if (fcntl(t->fd,F_SETLKW,&fl) || fstat(t->fd,&st)){
+			close(t->fd);
+			return -1;
 		}
 	}
-	return r;
+
+	if ((size_t)st.st_size < sizeof(RANKING)){
+		t->r = NULL;
+		if (esvazia(t,p))
+			return -1;
+		if (t->r == NULL){
+			fechaRanking(t);
+			return -1;
+		}
+		t->n = t->r->n;
+		return 0;
+	}
+
+	if (mapeia(t,st.st_size))
+		return -1;
+	cap = t->r->cap;
+	if (!memcmp(t->r->magic,RANK_MAGIC,4) && t->r->versao == RANK_VERSAO && cap > 0 && t->r->n >= 0 && t->r->n <= cap &&
+		(t->tam == tamRanking(cap) || (t->tam == tamRanking(2*cap) && fl.l_type == F_WRLCK))){
+		if (t->tam != tamRanking(cap))
+			refaz(t->r,2*cap);
+		if (t->r->periodo != p && fl.l_type == F_WRLCK){
+			munmap(t->r,t->tam);
+			t->r = NULL;
+			if (esvazia(t,p))
+				return -1;
+		}
+		t->n = (t->r->periodo == p) ? t->r->n : 0;
+		return 0;
+	}
+	fechaRanking(t);
+	return -1;
 }
 
 /**
-\brief Função de comparação utilizada no sorting.
+\brief Mapeia em memória o ficheiro de uma @c TABELA .
+
+Em caso de erro o ficheiro é fechado.
 
-@param a Primeiro valor a comparar.
-@param b Segundo valor a confirmar.
+@param t Tabela com o ficheiro aberto.
+@param tam Tamanho do ficheiro.
 
-@returns O valor da comparação.
+@returns 0 em caso de sucesso, -1 caso contrário.
 */
-static int cmp_info (const void * a, const void * b)
+static int mapeia (TABELA * t, size_t tam)
 {
-	return ( (*(INFO)b).wins - (*(INFO)a).wins);
+	void * m = mmap(NULL,tam,PROT_READ | PROT_WRITE,MAP_SHARED,t->fd,0);
+	if (m == MAP_FAILED){
+		close(t->fd);
+		t->fd = -1;
+		t->r = NULL;
+		return -1;
+	}
+	t->r = m;
+	t->tam = tam;
+	return 0;
 }
 
 /**
-\brief Efetua o sorting do array de @c INFO .
+\brief Deixa o ficheiro de uma @c TABELA vazio, com espaço para @c RANK_CAP registos, e mapeia-o.
+
+O ficheiro é truncado, pelo que a tabela de dispersão fica limpa sem ser percorrida.
+Em caso de erro o ficheiro é fechado.
 
-@param v Array que irá ser ordenado.
+@param t Tabela com o ficheiro aberto para escrita e não mapeado.
+@param periodo Período da janela de tempo a que o ficheiro passa a referir-se.
 
-@see size_info
+@returns 0 em caso de sucesso, -1 caso contrário.
 */
-static void sort_info (INFO v)
+static int esvazia (TABELA * t, int32_t periodo)
 {
-	int sz = size_info();
-	qsort(v,sz,sizeof(struct info),cmp_info);
+	if (ftruncate(t->fd,0) || ftruncate(t->fd,tamRanking(RANK_CAP))){
+		close(t->fd);
+		t->fd = -1;
+		return -1;
+	}
+	if (mapeia(t,tamRanking(RANK_CAP)))
+		return -1;
+	memcpy(t->r->magic,RANK_MAGIC,4);
+	t->r->versao = RANK_VERSAO;
+	t->r->n = 0;
+	t->r->cap = RANK_CAP;
+	t->r->periodo = periodo;
+	return 0;
 }
 
 /**
-\brief Função que indica um array de @c INFO contendo a leaderboard.
+\brief Fecha o ficheiro aberto com @c abreRanking , libertando a tranca.
 
-@param v Apontador para o endereço onde irá ser colocada a leaderboard.
-@param N Número máximo de elementos colocados.
+@param t Tabela aberta.
+*/
+static void fechaRanking (TABELA * t)
+{
+	if (t->r)
+		munmap(t->r,t->tam);
+	if (t->fd >= 0)
+		close(t->fd);
+}
 
-@returns Números de elementos colocados.
+/**
+\brief Passa um @c RANKING a ter espaço para mais registos, refazendo a tabela de dispersão.
 
-@see list_info
-@see sort_info
-@see INFO
+Os registos em uso mantêm a sua posição, e o espaço a seguir a estes, onde estava a
+tabela de dispersão antiga, é limpo.
+
+@param r Ranking mapeado, já com o tamanho de @c tamRanking(cap) .
+@param cap Novo número de registos.
+*/
+static void refaz (RANKING * r, int cap)
+{
+	int i;
+	memset(REGS(r) + r->n,0,sizeof(struct info)*(cap - r->n));
+	r->cap = cap;
+	memset(DISP(r),0,sizeof(int32_t)*2*cap);
+	for (i = 0 ; i < r->n ; i++)
+		*procura(r,REGS(r)[i].user) = i + 1;
+}
+
+/**
+\brief Duplica o espaço de uma @c TABELA .
+Em caso de erro a tabela deixa de estar mapeada, mas continua a ter de ser fechada com @c fechaRanking .
+
+@param t Tabela aberta para escrita.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
 */
-int get_info (INFO * v, int N)
+static int cresce (TABELA * t)
 {
-	int sz;
-	*v = list_info(&sz);
-	sort_info(*v);
-	if (sz > N){
-		*v = (INFO)realloc(*v,N);
-		sz = N;
+	int cap = 2*t->r->cap;
+	munmap(t->r,t->tam);
+	t->r = NULL;
+	if (ftruncate(t->fd,tamRanking(cap)) || mapeia(t,tamRanking(cap)))
+		return -1;
+	refaz(t->r,cap);
+	return 0;
+}
+
+/**
+\brief Procura um utilizador na tabela de dispersão, por dispersão do nome (FNV-1a) e sondagem linear.
+
+@param r Ranking mapeado.
+@param user Utilizador.
+
+@param r Ranking mapeado.
+@param user Utilizador.
+
+@returns A posição da tabela com o registo do utilizador, ou a posição vazia onde este deve ser colocado.
+*/
+static int32_t * procura (RANKING * r, char * user)
+{
+	uint32_t h = 2166136261u, m = 2*r->cap - 1;
+	int32_t * d = DISP(r);
+	char * c;
+
+	for (c = user ; *c ; c++)
+		h = (h ^ (unsigned char)*c) * 16777619u;
+	for (h &= m ; d[h] && strcmp(REGS(r)[d[h] - 1].user,user) ; h = (h + 1) & m)
+		;
+	return d + h;
+}
+
+
+/**
+\brief Troca dois registos de posição, atualizando a tabela de dispersão.
+
+@param r Ranking mapeado.
+@param a Posição do primeiro registo.
+@param b Posição do segundo registo.
+*/
+static void troca (RANKING * r, int a, int b)
+{
+	struct info aux;
+	INFO v = REGS(r);
+	int32_t * pa, * pb;
+	if (a == b)
+		return;
+	pa = procura(r,v[a].user);
+	pb = procura(r,v[b].user);
+	aux = v[a];
+	v[a] = v[b];
+	v[b] = aux;
+	*pa = b + 1;
+	*pb = a + 1;
+}
+
+/**
+\brief Pesquisa binária num intervalo de registos ordenado por número decrescente de vitórias.
+
+@param v Registos.
+@param lo Início do intervalo.
+@param hi Fim do intervalo, exclusivo.
+@param wins Número de vitórias.
+@param estrito Diferente de 0 para procurar o primeiro registo com menos de @p wins vitórias,
+ou 0 para procurar o primeiro com @p wins ou menos vitórias.
+
+@returns A posição encontrada, ou @p hi caso não exista.
+*/
+static int corte (INFO v, int lo, int hi, int wins, int estrito)
+{
+	int m;
+	while (lo < hi){
+		m = lo + (hi - lo)/2;
+		if (v[m].wins < wins || (!estrito && v[m].wins == wins))
+			hi = m;
+		else
+			lo = m + 1;
 	}
-	return sz;
-}
\ No newline at end of file
+	return lo;
+}
+
+/**
+\brief Altera o número de vitórias de um registo, movendo-o para manter a ordem.
+
+Como a ordem entre registos com o mesmo número de vitórias é indiferente, o registo passa cada
+grupo destes trocando com o primeiro, ou o último, registo do grupo, encontrado por pesquisa binária.
+
+@param r Ranking mapeado.
+@param i Posição do registo.
+@param wins Novo número de vitórias.
+*/
+static void move (RANKING * r, int i, int wins)
+{
+	INFO v = REGS(r); int k;
+
+	if (wins > v[i].wins)
+		while (i > 0 && v[i-1].wins < wins){
+			k = corte(v,0,i,v[i-1].wins,0);
+			troca(r,i,k);
+			i = k;
+		}
+	else
+		while (i < r->n - 1 && v[i+1].wins > wins){
+			k = corte(v,i+1,r->n,v[i+1].wins,1) - 1;
+			troca(r,i,k);
+			i = k;
+		}
+	v[i].wins = wins;
+}
+
+/**
+\brief Insere um utilizador novo, na posição correspondente às suas vitórias.
+
+@param t Tabela aberta para escrita.
+@param user Utilizador.
+@param wins Número de vitórias.
+*/
+static void insere (TABELA * t, char * user, int wins)
+{
+	INFO v; int i;
+
+	if (t->r->n == t->r->cap && cresce(t))
+		return;
+	v = REGS(t->r);
+	i = t->r->n++;
+	memset(&v[i],0,sizeof(struct info));
+	strncpy(v[i].user,user,MAX_S-1);
+	v[i].wins = INT_MIN;
+	*procura(t->r,v[i].user) = i + 1;
+	move(t->r,i,wins);
+}
+
+/**
+\brief Altera o número de vitórias de um utilizador numa janela de tempo, inserindo-o se for novo.
+
+@param janela @c JANELA de tempo.
+@param user Utilizador.
+@param wins Número de vitórias.
+@param soma Diferente de 0 para somar @p wins às vitórias que o utilizador já tem.
+
+@see procura
+@see move
+@see insere
+*/
+static void atualiza (int janela, char * user, int wins, int soma)
+{
+	TABELA t; int32_t * p;
+
+	if (abreRanking(&t,janela,1))
+		return;
+	if (*(p = procura(t.r,user)))
+		move(t.r,*p - 1,soma ? REGS(t.r)[*p - 1].wins + wins : wins);
+	else
+		insere(&t,user,wins);
+	fechaRanking(&t);
+}
+
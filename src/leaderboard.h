@@ -3,8 +3,8 @@
 \brief Módulo de obtenção da leaderboard.
 */
 
-#ifndef USER_H
-#define USER_H
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
 
 // ------------------------------------------------------------------------------
 
@@ -13,6 +13,34 @@
 */
 #define MAX_S 	50
 
+/**
+\brief Número de posições da leaderboard que podem ser vistas.
+*/
+#define TOP_K 	100
+
+/**
+\brief Número de posições da leaderboard em cada página do menu.
+*/
+#define POR_PAGINA 	5
+
+/**
+\brief Janelas de tempo da leaderboard, cada uma com o seu ranking.
+
+As janelas do mês, da semana e do dia seguem o calendário, em UTC, e só contam as vitórias
+obtidas no período atual.
+*/
+typedef enum {
+	JAN_TOTAL,
+	JAN_MES,
+	JAN_SEMANA,
+	JAN_DIA
+} JANELA;
+
+/**
+\brief Número de janelas de tempo da leaderboard.
+*/
+#define NJANELAS 	4
+
 // ------------------------------------------------------------------------------
 
 /**
@@ -26,8 +54,16 @@ char * getInfo_user (INFO v, int i);
 
 int getInfo_wins (INFO v, int i);
 
-int get_info (INFO * v, int N);
+int get_info (INFO * v, int janela, int ini, int N);
+
+int get_range (INFO * v, int janela, int from, int to);
+
+int get_rank (char * user, int janela, int * total);
 
 void push_info (char * user, int wins);
 
+void win_info (char * user, int wins);
+
+int importa_info (char * ficheiro);
+
 #endif
\ No newline at end of file
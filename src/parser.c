@@ -9,6 +9,8 @@
 #include "stdio.h"
 #include <string.h>
 #include "userfiles.h"
+#include "armazem.h"
+#include "leaderboard.h"
 #include "decide.h"
 #include "filemanager.h"
 #include "state.h"
@@ -18,23 +20,26 @@
 // ------------------------------------------------------------------------------
 
 /* Metódos públicos */
-void pipe_env(void);
+int pipe_env(void);
 
 /* Metódos privados */
 static int main_op (ESTADO e, char * command);
 static void snd_op (ESTADO e, char * command);
 static int get_resize (ESTADO e, char * command);
 static int read_menu (ESTADO e, char * command);
+static int read_checkpoint (ESTADO e, char * command);
+static int nomeValido (char * nome);
 static int choose_load (ESTADO e, char * command);
 static void load_map (ESTADO e, char * command);
 static void load_id (ESTADO e, char * command);
 static int load_random (ESTADO e, char * name);
 static int makePlay(ESTADO e, char * command);
 static int readParse (char * command, int * i, int * j);
-static ESTADO load_user (char * user);
+static ESTADO load_user (char * user, int * novo);
+static int vistaAltera (ESTADO e, int novo);
 static char * put_user (char * userQuery);
 static char * convert(char *ler);
-static int getUserC(char *query, char *user, char *command);
+static int getUserC(char *query, char *user, char *command, char *modo);
 
 // ------------------------------------------------------------------------------
 
@@ -55,37 +60,74 @@ Para a leitura de utilizadores e comandos há três situações, consoante o nú
 - Caso seja lido o utilizador e o comando, é apresentado o @c ESTADO corresponde com as alterações do comando já efetuadas.
 	- Neste caso acima, primeiro são analisadas as operações principais, e caso nenhuma seja efetuada, então passa para as operações secundárias.
 
-No final, o @c ESTADO é escrito em ficheiro.
+O utilizador fica trancado durante todo o pedido, de forma partilhada caso não haja comando.
+Caso um pedido sem comando vá alterar o estado, o que é verificado com @c vistaAltera , a tranca passa
+a exclusiva e o @c ESTADO é lido de novo. No final, caso a tranca seja exclusiva, o @c ESTADO é escrito no
+@c ARMAZEM , tal como as sessões alteradas há mais de @c SESSOES_ATRASO segundos, e o armazém é fechado
+de seguida, sincronizando todas as escritas do pedido e libertando a tranca.
+
+Caso a uma jogada numa peça se siga o modo @b json , a página não é desenhada: é escrito com
+@c printdiff o JSON das peças alteradas, para o cliente atualizar a página que já tem.
 
 @see getUserC
 @see convert
 @see selectFile
+@see trancaUser
 @see load_user
+@see vistaAltera
 @see main_op
 @see snd_op
 @see estado2file
+@see varreSessoes
+@see fechaArmazem
 @see printstate
+@see printdiff
 @see destroyState
+
+@returns 1 caso tenha sido escrito JSON em vez da página, 0 caso contrário.
 */
-void pipe_env (void)
+int pipe_env (void)
 {
 	char * query = getenv("QUERY_STRING");
-	char user[50], command[50];
-	int nRead = getUserC(convert(query),user,command);
+	char user[50], command[50], modo[50];
+	int nRead = getUserC(convert(query),user,command,modo);
+	int i, j, ramos = 0, json = 0, novo, exclusivo;
 
-	ESTADO state;
+	ESTADO state, antes = NULL;
 	strcpy(user,put_user(user));
 	if (nRead < 1 || !strcmp(user,""))
 		selectFile("User Name", "newUser");
 	else {
-		state = load_user(user);
-		if (nRead == 2)
+		exclusivo = nRead >= 2;
+		trancaUser(user, exclusivo);
+		state = load_user(user, &novo);
+		if (!exclusivo && vistaAltera(state, novo)){
+			destroyState(state);
+			exclusivo = 1;
+			trancaUser(user, exclusivo);
+			state = load_user(user, &novo);
+		}
+		json = nRead == 3 && !strcmp(modo, "json") && readParse(command,&i,&j) == 2;
+		if (json){
+			antes = snapshotState(state);
+			ramos = nRamos(getE_hist(state));
+		}
+		if (nRead >= 2)
 			if(!main_op(state,command))
 				snd_op(state,command);
-		printstate(state, tabSize);
-		estado2file(user, state);
+		if (json){
+			printdiff(antes, ramos, state);
+			destroyState(antes);
+		}
+		else
+			printstate(state, tabSize);
+		if (exclusivo)
+			estado2file(user, state);
+		varreSessoes();
+		fechaArmazem();
 		destroyState(state);
 	}
+	return json;
 }
 
 /**
@@ -96,6 +138,7 @@ Estes comandos mais importantes correspondem aos seguintes:
 - Efetuar uma jogada na grelha.
 - Efetuar operações de redimensão.
 - Alterar o menu do @c ESTADO.
+- Guardar ou recuperar um checkpoint com nome.
 - Fazer load de uma grelha guardada em ficheiro.
 
 @param e @c ESTADO que irá ser alterado.
@@ -106,6 +149,7 @@ Estes comandos mais importantes correspondem aos seguintes:
 @see makePlay
 @see get_resize
 @see read_menu
+@see read_checkpoint
 @see choose_load
 */
 static int main_op (ESTADO e, char * command)
@@ -114,6 +158,7 @@ static int main_op (ESTADO e, char * command)
 	r = makePlay(e,command);
 	if (!r) r = get_resize(e,command);
 	if (!r) r = read_menu(e,command);
+	if (!r) r = read_checkpoint(e,command);
 	if (!r) r = choose_load(e,command);
 	if (!r) r = load_random(e,command);
 	return r;
@@ -131,11 +176,12 @@ aos seguintes comandos.
 - help : givehelp.
 - undo : pipestack, com o segundo argumento a 0.
 - redo : pipestack, com o segundo argumento a 1.
+- branch : changeBranch.
 - solve : solve.
 - clear : clearstate.
-- saveCheckpoint : saveAnc.
+- saveCheckpoint : saveAnc, sem nome.
 - safedraw : safedraw.
-- getAnc : pop_Anc.
+- getAnc : pop_Anc, para o checkpoint mais recente.
 - clearS : clearcanvas.
 .
 
@@ -144,6 +190,7 @@ aos seguintes comandos.
 
 @see givehelp
 @see pipestack
+@see changeBranch
 @see solve
 @see clearstate
 @see saveAnc
@@ -160,16 +207,18 @@ static void snd_op (ESTADO e, char * command)
 		pipestack(e, 0);
 	if (!strcmp(command, "redo"))
 		pipestack(e, 1);
+	if (!strcmp(command, "branch"))
+		changeBranch(e);
 	if (!strcmp(command, "solve"))
 		e = solve(e, &nsol);
 	if (!strcmp(command, "clear"))
 		clearstate(e);
 	if (!strcmp(command, "saveCheckpoint"))
-		saveAnc(e);
+		saveAnc(e, NULL);
 	if (!strcmp(command, "safedraw"))
 		safedraw(e);
 	if (!strcmp(command, "getAnc"))
-		pop_Anc(e);
+		pop_Anc(e, NULL);
 	if (!strcmp(command, "clearS"))
 		clearcanvas(e);
 }
@@ -201,6 +250,9 @@ static int get_resize (ESTADO e, char * command)
 
 A função lê o menu para o qual se pretende alterar e faz a devida alteração,
 sendo que quando o estado corresponde a MENU_INDEX::SELECT_MENU o @c ESTADO é inicializado.
+O comando @b L seguido de um número abre essa página da leaderboard, e seguido também de @b J
+e do número de uma @c JANELA , abre essa página da leaderboard dessa janela de tempo.
+O comando @b P seguido de um número abre essa página do menu de escolher mapas.
 
 @param e @c ESTADO que irá ser alterado.
 @param command Comando passado na @b QUERY_STRING.
@@ -209,11 +261,13 @@ sendo que quando o estado corresponde a MENU_INDEX::SELECT_MENU o @c ESTADO é i
 
 @see setE_menu
 @see getE_menu
+@see setE_pagina
+@see setE_janela
 @see inicializar
 */
 static int read_menu (ESTADO e, char * command)
 {
-	int menu, r = 1;
+	int menu, pagina, janela = JAN_TOTAL, r = 1;
 	if (sscanf(command, "M%d", &menu) > 0)
 	{
 		setE_menu(e, menu);
@@ -223,11 +277,69 @@ static int read_menu (ESTADO e, char * command)
 				setE_base(e,NULL);
 			}
 	}
+	else if (sscanf(command, "L%dJ%d", &pagina, &janela) > 0 && pagina >= 0 && pagina * POR_PAGINA < TOP_K &&
+		janela >= 0 && janela < NJANELAS)
+	{
+		setE_menu(e, LEADERBOARD);
+		setE_pagina(e, pagina);
+		setE_janela(e, janela);
+	}
+	else if (sscanf(command, "P%d", &pagina) > 0 && pagina >= 0)
+	{
+		setE_menu(e, SELECT_MAP);
+		setE_pagina(e, pagina);
+	}
+	else
+		r = 0;
+	return r;
+}
+
+/**
+\brief Efetua a leitura de um comando de checkpoint com nome.
+
+Os comandos têm a forma @c saveCheckpoint=nome, que guarda um checkpoint com
+esse nome, e @c getAnc=nome, que volta ao checkpoint com esse nome.
+Caso o nome seja vazio, tenha mais de @c MAX_ANC_NOME - 1 carateres, ou carateres
+que não sejam letras ou algarismos, o comando é ignorado e o @c ESTADO não é alterado.
+
+@param e @c ESTADO que irá ser alterado.
+@param command Comando obtido da @b QUERY_STRING.
+
+@returns 1 se o comando corresponde a um checkpoint com nome, 0 caso contrário.
+
+@see nomeValido
+@see saveAnc
+@see pop_Anc
+*/
+static int read_checkpoint (ESTADO e, char * command)
+{
+	int r = 1;
+	if (!strncmp(command, "saveCheckpoint=", 15)){
+		if (nomeValido(command + 15))
+			saveAnc(e, command + 15);
+	}
+	else if (!strncmp(command, "getAnc=", 7)){
+		if (nomeValido(command + 7))
+			pop_Anc(e, command + 7);
+	}
 	else
 		r = 0;
 	return r;
 }
 
+/**
+\brief Verifica se um nome de checkpoint é válido.
+
+@param nome Nome a verificar.
+
+@returns 1 se o nome não é vazio, tem no máximo @c MAX_ANC_NOME - 1 carateres, e só tem letras e algarismos, 0 caso contrário.
+*/
+static int nomeValido (char * nome)
+{
+	size_t n = strspn(nome, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
+	return n > 0 && n < MAX_ANC_NOME && nome[n] == '\0';
+}
+
 /**
 \brief Consoante o comando passado na @b QUERY_STRING decide que tipo de load terá de ser feito.
 
@@ -269,6 +381,8 @@ static int load_random (ESTADO e, char * name)
 			setE_helpB(e);
 			destroyState(tmp);
 		} else {
+			if (tmp)
+				destroyState(tmp);
 			setE_menu(e, INVALID_RANDOM);
 			r = 0;
 		}
@@ -306,8 +420,11 @@ static void load_map (ESTADO e, char * command)
 		setE_menu(e, CONFIRM_MAP);
 		setE_helpB(e);
 	}
-	else
+	else {
+		if (tmp)
+			destroyState(tmp);
 		setE_menu(e, INVALID_MAP);
+	}
 }
 
 /**
@@ -315,12 +432,14 @@ static void load_map (ESTADO e, char * command)
 
 Lê o mapa contido em ficheiro, fazendo a verificação da sua validade, 
 e se este for válido, coloca em @p e a grelha correspondente. Caso contrário,
-coloca o utilizador no menu de mapa inválido.
+coloca o utilizador no menu de mapa inválido. Caso os mapas estejam compilados
+num pacote, é usada a validade verificada pelo compilador.
 
 @param e @c ESTADO onde irá ser colocada a grelha lida.
 @param command String correspondente ao comando passado na @b QUERY_STRING.
 
-@see SELECT
+@see leMapa
+@see validoMapa
 @see setE_state
 @see setE_menu
 @see destroyState
@@ -328,14 +447,24 @@ coloca o utilizador no menu de mapa inválido.
 static void load_id (ESTADO e, char * command)
 {
 	ESTADO aux;
-	int id;
+	CATALOGO c;
+	int id, valido = 0;
 
 	sscanf(command, "$%d", &id);
-	aux = SELECT(id);
+	if ((c = CATALOGO_ARCADE()) != NULL){
+		aux = leMapa(c, id);
+		valido = validoMapa(c, id);
+		fechaCatalogo(c);
+	}
+	else
+		aux = SELECT(id);
+	if (valido < 0)
+		valido = validTab(aux);
 	setE_user(aux,getE_user(e));
 	setE_wins(aux,getE_wins(e));
 	setE_state(e,aux);
-	if (validTab(aux))
+	setE_mapa(e,id);
+	if (valido)
 		setE_menu(e, CONFIRM_MAP);
 	else
 		setE_menu(e, INVALID_MAP);
@@ -392,6 +521,7 @@ Cria o @c ESTADO guardado em ficheiro de um certo utilizador, ou caso este
 não exista, cria um novo @c ESTADO que será associado ao utilizador passado como argumentos.
 
 @param user O utilizador do qual se pretende fazer load.
+@param novo Apontador onde é colocado 1 caso o utilizador não exista, 0 caso contrário.
 
 @returns O @c ESTADO lido.
 
@@ -400,12 +530,14 @@ não exista, cria um novo @c ESTADO que será associado ao utilizador passado co
 @see inicializar
 @see setE_menu
 */
-static ESTADO load_user (char * user)
+static ESTADO load_user (char * user, int * novo)
 {
 	ESTADO e; int flag;
 
 	e = file2estado(user,flag);
+	*novo = !flag;
 	if (!flag){
+		destroyState(e);
 		e = inicializar(user,5,5);
 		setE_menu(e, INITIAL_MENU);
 	}
@@ -413,6 +545,24 @@ static ESTADO load_user (char * user)
 	return e;
 }
 
+/**
+\brief Verifica se um pedido sem comando vai alterar o @c ESTADO de um utilizador.
+
+Um pedido sem comando só altera o estado quando o utilizador é novo, e tem de ser guardado,
+ou quando o tabuleiro está completo, pois @c printstate conta a vitória com @c victory .
+
+@param e @c ESTADO lido.
+@param novo 1 caso o utilizador não exista.
+
+@returns 1 caso o estado vá ser alterado, 0 caso contrário.
+
+@see victory
+*/
+static int vistaAltera (ESTADO e, int novo)
+{
+	return novo || getE_vazias(e) == 0;
+}
+
 /**
 \brief Identifica em que posição de encontra o identificador do utilizador.
 
@@ -459,13 +609,14 @@ Identifica, caso existam, o utilizador e o comando passado na @b QUERY_STRING.
 @param query @b QUERY de onde se irá retirar o utilizador e o comando.
 @param user Apontador de onde irá ser colocado o utilizador passado na @b QUERY
 @param command Apontador de onde irá ser colocado o comando passado na @b QUERY.
+@param modo Apontador de onde irá ser colocado o modo de resposta, a seguir ao comando, caso exista.
 
 @returns O número de inputs lidos com sucesso.
 */
-static int getUserC(char *query, char *user, char *command)
+static int getUserC(char *query, char *user, char *command, char *modo)
 { 
 	int r = 0;
 	if (query != NULL)
-		r = sscanf(query, "%s %s", user, command);
+		r = sscanf(query, "%s %s %49s", user, command, modo);
 	return r;
 }
\ No newline at end of file
@@ -5,6 +5,6 @@
 #ifndef DECIDE_H
 #define DECIDE_H
 
-void pipe_env (void);
+int pipe_env (void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+/**
+*@file saida.c
+\brief Módulo da SAIDA, o buffer onde é acumulada a página antes de ser enviada.
+
+A página é escrita por partes num buffer que só cresce, sem passar pelo stdio, e os inteiros
+são formatados à mão. No fim do pedido a página é enviada de uma só vez com @c writev ,
+precedida do cabeçalho, que já pode ter o @b Content-Length .
+
+Caso o cliente aceite, segundo @b HTTP_ACCEPT_ENCODING , as páginas com pelo menos
+@c SAIDA_MINIMO bytes são comprimidas com gzip, ou deflate, num nível rápido.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "saida.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// ------------------------------------------------------------------------------
+
+/* Métodos públicos */
+void poeBytes(const char *s, size_t tam);
+void poeTexto(const char *s);
+void poeInt(long n);
+void poeFormato(const char *fmt, ...);
+const char *conteudoSaida(size_t *tam);
+void limpaSaida();
+int enviaSaida(const char *tipo);
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Capacidade inicial do buffer.
+*/
+#define SAIDA_INICIAL 65536
+
+/**
+\brief Tamanho mínimo de uma página para ser comprimida.
+*/
+#define SAIDA_MINIMO 1024
+
+/**
+\brief Nível de compressão, a favor da rapidez, já que o SVG repetitivo comprime bem de qualquer forma.
+*/
+#define SAIDA_NIVEL 1
+
+/**
+\brief Compressões da página, pela ordem de preferência.
+*/
+typedef enum {SEM_COMPRESSAO, GZIP, DEFLATE} COMPRESSAO;
+
+/**
+\brief Buffer da página.
+*/
+static struct
+{
+	char *v;      /**< Conteúdo */
+	size_t n;     /**< Número de bytes escritos */
+	size_t cap;   /**< Capacidade */
+} saida = {NULL, 0, 0};
+
+/* Métodos privados */
+static char *reserva(size_t tam);
+static int aceita(const char *lista, const char *nome);
+static COMPRESSAO compressao();
+static char *comprime(COMPRESSAO c, size_t *tam);
+static int envia(struct iovec *v, int n);
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Garante que cabem mais @p tam bytes no buffer, duplicando a sua capacidade se for preciso.
+
+@param tam Número de bytes a escrever.
+
+@returns O fim do conteúdo, onde os bytes devem ser escritos.
+*/
+static char *reserva(size_t tam)
+{
+	size_t cap = saida.cap ? saida.cap : SAIDA_INICIAL;
+
+	while (cap < saida.n + tam)
+		cap *= 2;
+	if (cap != saida.cap)
+	{
+		saida.v = realloc(saida.v, cap);
+		saida.cap = cap;
+	}
+	return saida.v + saida.n;
+}
+
+/**
+\brief Indica se uma codificação é aceite, numa lista como a do cabeçalho @b Accept-Encoding .
+
+@param lista Codificações aceites, separadas por vírgulas, cada uma com um @b q opcional.
+@param nome Codificação a procurar.
+
+@returns 1 se a codificação está na lista sem @b q=0 , 0 caso contrário.
+*/
+static int aceita(const char *lista, const char *nome)
+{
+	size_t n = strlen(nome);
+	const char *p = lista, *q;
+
+	while (*p)
+	{
+		while (*p == ' ' || *p == '\t' || *p == ',')
+			p++;
+		if (!strncasecmp(p, nome, n) && (p[n] == '\0' || p[n] == ',' || p[n] == ';' || p[n] == ' '))
+		{
+			q = strchr(p + n, ',');
+			p = strstr(p + n, "q=");
+			return !(p && (!q || p < q) && strtod(p + 2, NULL) == 0);
+		}
+		while (*p && *p != ',')
+			p++;
+	}
+	return 0;
+}
+
+/**
+\brief Escolhe a compressão da página, segundo @b HTTP_ACCEPT_ENCODING e o tamanho da página.
+*/
+static COMPRESSAO compressao()
+{
+	const char *lista = getenv("HTTP_ACCEPT_ENCODING");
+
+	if (lista == NULL || saida.n < SAIDA_MINIMO)
+		return SEM_COMPRESSAO;
+	if (aceita(lista, "gzip"))
+		return GZIP;
+	if (aceita(lista, "deflate"))
+		return DEFLATE;
+	return SEM_COMPRESSAO;
+}
+
+/**
+\brief Comprime a página.
+
+@param c Compressão, gzip ou deflate (zlib).
+@param tam Onde é colocado o tamanho da página comprimida.
+
+@returns A página comprimida, que deve ser libertada com @c free , ou NULL caso não compense.
+*/
+static char *comprime(COMPRESSAO c, size_t *tam)
+{
+	z_stream z;
+	char *v;
+
+	memset(&z, 0, sizeof(z));
+	if (deflateInit2(&z, SAIDA_NIVEL, Z_DEFLATED, c == GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return NULL;
+	*tam = deflateBound(&z, saida.n);
+	v = malloc(*tam);
+	z.next_in = (Bytef *)saida.v;
+	z.avail_in = saida.n;
+	z.next_out = (Bytef *)v;
+	z.avail_out = *tam;
+	if (deflate(&z, Z_FINISH) != Z_STREAM_END || z.total_out >= saida.n)
+	{
+		free(v);
+		v = NULL;
+	}
+	*tam = z.total_out;
+	deflateEnd(&z);
+	return v;
+}
+
+/**
+\brief Escreve um conjunto de buffers no stdout, até ao fim.
+
+@param v Buffers, que são alterados.
+@param n Número de buffers.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+static int envia(struct iovec *v, int n)
+{
+	ssize_t r;
+	int k = 0;
+
+	while (k < n)
+	{
+		if ((r = writev(STDOUT_FILENO, v + k, n - k)) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		for (; k < n && (size_t)r >= v[k].iov_len; k++)
+			r -= v[k].iov_len;
+		if (k < n)
+		{
+			v[k].iov_base = (char *)v[k].iov_base + r;
+			v[k].iov_len -= r;
+		}
+	}
+	return 0;
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Acrescenta bytes à página.
+
+@param s Bytes a acrescentar.
+@param tam Número de bytes.
+*/
+void poeBytes(const char *s, size_t tam)
+{
+	memcpy(reserva(tam), s, tam);
+	saida.n += tam;
+}
+
+/**
+\brief Acrescenta uma string à página.
+
+@param s String a acrescentar.
+*/
+void poeTexto(const char *s)
+{
+	poeBytes(s, strlen(s));
+}
+
+/**
+\brief Acrescenta um inteiro à página, em decimal.
+
+@param n Inteiro a acrescentar.
+*/
+void poeInt(long n)
+{
+	char buf[24], *p = buf + sizeof(buf);
+	unsigned long u = (n < 0) ? -(unsigned long)n : (unsigned long)n;
+
+	do
+		*--p = (char)('0' + u % 10);
+	while (u /= 10);
+	if (n < 0)
+		*--p = '-';
+	poeBytes(p, buf + sizeof(buf) - p);
+}
+
+/**
+\brief Acrescenta texto formatado à página, como o @c printf , para os casos menos frequentes.
+
+@param fmt Formato.
+*/
+void poeFormato(const char *fmt, ...)
+{
+	va_list ap;
+	int tam;
+
+	va_start(ap, fmt);
+	tam = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	if (tam < 0)
+		return;
+	va_start(ap, fmt);
+	vsnprintf(reserva(tam + 1), tam + 1, fmt, ap);
+	va_end(ap);
+	saida.n += tam;
+}
+
+/**
+\brief Conteúdo da página escrito até agora.
+
+@param tam Onde é colocado o tamanho do conteúdo.
+
+@returns O conteúdo, que não termina em '\\0', e que deixa de ser válido quando a página é alterada.
+*/
+const char *conteudoSaida(size_t *tam)
+{
+	*tam = saida.n;
+	return saida.v;
+}
+
+/**
+\brief Descarta o conteúdo da página, mantendo o buffer.
+*/
+void limpaSaida()
+{
+	saida.n = 0;
+}
+
+/**
+\brief Envia a página para o stdout, de uma só vez, precedida do cabeçalho, e descarta-a.
+
+A página é comprimida caso o cliente o aceite e esta tenha pelo menos @c SAIDA_MINIMO bytes.
+
+@param tipo Tipo do conteúdo, para o @b Content-Type .
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+*/
+int enviaSaida(const char *tipo)
+{
+	char cab[192], *z = NULL;
+	struct iovec v[2];
+	COMPRESSAO c = compressao();
+	size_t tam = saida.n;
+	int r, n;
+
+	if (c != SEM_COMPRESSAO && (z = comprime(c, &tam)) == NULL)
+	{
+		c = SEM_COMPRESSAO;
+		tam = saida.n;
+	}
+	n = snprintf(cab, sizeof(cab), "Content-Type: %s\n%s%sVary: Accept-Encoding\nContent-Length: %zu\n\n",
+				 tipo, c == SEM_COMPRESSAO ? "" : "Content-Encoding: ", c == GZIP ? "gzip\n" : c == DEFLATE ? "deflate\n" : "",
+				 tam);
+
+	v[0].iov_base = cab;
+	v[0].iov_len = n;
+	v[1].iov_base = z ? z : saida.v;
+	v[1].iov_len = tam;
+	fflush(stdout);
+	r = envia(v, 2);
+	free(z);
+	limpaSaida();
+	return r;
+}
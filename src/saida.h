@@ -0,0 +1,26 @@
+/**
+*@file saida.h
+\brief Módulo da SAIDA, o buffer onde é acumulada a página antes de ser enviada.
+*/
+#ifndef SAIDA_H
+#define SAIDA_H
+
+#include <stddef.h>
+
+// ------------------------------------------------------------------------------
+
+void poeBytes (const char * s, size_t tam);
+
+void poeTexto (const char * s);
+
+void poeInt (long n);
+
+void poeFormato (const char * fmt, ...);
+
+const char * conteudoSaida (size_t * tam);
+
+void limpaSaida ();
+
+int enviaSaida (const char * tipo);
+
+#endif
@@ -0,0 +1,390 @@
+/**
+*@file sessoes.c
+\brief Módulo das SESSOES, a cache dos utilizadores ativos em memória partilhada entre processos.
+
+O segmento de memória partilhada é um array de @c NCONJUNTOS x @c VIAS sessões. Cada utilizador
+só pode estar nas @c VIAS sessões do conjunto escolhido por dispersão do seu nome, pelo que a
+procura não precisa de tranca: basta comparar a marca de cada sessão do conjunto, e só depois
+prender a sessão encontrada. Uma sessão é presa por um processo de cada vez, com uma troca atómica
+do campo @c dono , durante o tempo de copiar o registo de ou para a sessão.
+
+Cada sessão guarda o registo binário do utilizador, no mesmo formato que o @c ARMAZEM .
+As sessões alteradas só são escritas no armazém quando são descartadas para dar lugar a outro
+utilizador, ou por @c varreS , passados @c SESSOES_ATRASO segundos.
+
+Ao contrário do armazém, as sessões não sobrevivem a um reinício da máquina: as alterações que ainda
+não foram escritas perdem-se. Como @c varreS só é chamada no fim de um pedido, um utilizador que deixe
+de jogar ficaria com as últimas jogadas só em memória até que outro pedido chegasse, pelo que o
+programa @b descarregar deve ser corrido periodicamente, instalado no cron a cada minuto, e antes
+de a máquina ser desligada. As perdas ficam assim limitadas ao último minuto.
+
+O segmento é criado só com permissões para o seu dono, pelo que o @b GandaGalo e o @b descarregar
+devem correr com o mesmo utilizador, o do servidor web.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sessoes.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// ------------------------------------------------------------------------------
+
+/* Metódos públicos */
+SESSOES abreS(GUARDAR guardar, void *ctx);
+void fechaS(SESSOES s);
+char *leS(SESSOES s, char *user, size_t *tam);
+int escreveS(SESSOES s, char *user, const char *buf, size_t tam, int insere, int sujo);
+void removeS(SESSOES s, char *user);
+void varreS(SESSOES s, int atraso);
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Número de conjuntos de sessões.
+*/
+#define NCONJUNTOS 64
+
+/**
+\brief Número de sessões de cada conjunto.
+*/
+#define VIAS 4
+
+/**
+\brief Tamanho máximo do nome de um utilizador numa sessão, incluindo o terminador.
+*/
+#define MAX_NOME 64
+
+/**
+\brief Sessão de um utilizador, no segmento de memória partilhada.
+*/
+typedef struct sessao
+{
+	_Atomic int32_t dono;    /**< Processo que prendeu a sessão, 0 se nenhum */
+	_Atomic uint32_t marca;  /**< Dispersão do nome do utilizador, 0 se a sessão estiver livre */
+	_Atomic int64_t uso;     /**< Instante do último uso */
+	int64_t desde;           /**< Instante em que a sessão ficou por escrever no armazém */
+	int32_t sujo;            /**< Diferente de 0 se a sessão não está escrita no armazém */
+	int32_t tam;             /**< Tamanho do registo */
+	char user[MAX_NOME];     /**< Nome do utilizador */
+	char dados[SESSOES_REGISTO]; /**< Registo binário do utilizador */
+} SESSAO;
+
+/**
+\brief Tamanho do segmento de memória partilhada.
+*/
+#define TAM_SEGMENTO (sizeof(SESSAO) * NCONJUNTOS * VIAS)
+
+/**
+\brief Estrutura principal das sessões.
+*/
+struct sessoes
+{
+	SESSAO *v;               /**< Sessões do segmento */
+	GUARDAR guardar;         /**< Função que escreve uma sessão no armazém */
+	void *ctx;               /**< Contexto de @c guardar */
+};
+
+/* Metódos privados */
+static uint32_t marcar(char *user);
+static int64_t agora();
+static int prende(SESSAO *x, int espera);
+static void solta(SESSAO *x);
+static SESSAO *procura(SESSOES s, char *user);
+static SESSAO *ocupa(SESSOES s, char *user);
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Marca de um utilizador, obtida por dispersão do nome (FNV-1a).
+
+@param user Nome do utilizador.
+
+@returns A marca, nunca 0. O conjunto do utilizador é a marca módulo @c NCONJUNTOS .
+*/
+static uint32_t marcar(char *user)
+{
+	uint32_t h = 2166136261u;
+	for (; *user; user++)
+		h = (h ^ (unsigned char)*user) * 16777619u;
+	return h ? h : 1;
+}
+
+/**
+\brief Instante atual, em segundos.
+*/
+static int64_t agora()
+{
+	return (int64_t)time(NULL);
+}
+
+/**
+\brief Prende uma sessão ao processo.
+
+Caso a sessão esteja presa por um processo que já terminou, esta é-lhe retirada.
+
+@param x Sessão.
+@param espera Diferente de 0 para esperar que a sessão seja solta.
+
+@returns 1 se a sessão foi presa, 0 caso contrário.
+*/
+static int prende(SESSAO *x, int espera)
+{
+	int32_t d, pid = getpid();
+	for (;;)
+	{
+		d = 0;
+		if (atomic_compare_exchange_strong(&x->dono, &d, pid))
+			return 1;
+		if (kill(d, 0) && errno == ESRCH && atomic_compare_exchange_strong(&x->dono, &d, pid))
+			return 1;
+		if (!espera)
+			return 0;
+		sched_yield();
+	}
+}
+
+/**
+\brief Solta uma sessão presa com @c prende .
+*/
+static void solta(SESSAO *x)
+{
+	atomic_store(&x->dono, 0);
+}
+
+/**
+\brief Procura a sessão de um utilizador, prendendo-a.
+
+@param s Sessões.
+@param user Nome do utilizador.
+
+@returns A sessão, presa pelo processo, ou NULL caso o utilizador não tenha sessão.
+*/
+static SESSAO *procura(SESSOES s, char *user)
+{
+	uint32_t m = marcar(user);
+	SESSAO *x = s->v + (m % NCONJUNTOS) * VIAS;
+	int k;
+
+	for (k = 0; k < VIAS; k++, x++)
+		if (atomic_load(&x->marca) == m && prende(x, 1))
+		{
+			if (atomic_load(&x->marca) == m && !strcmp(x->user, user))
+				return x;
+			solta(x);
+		}
+	return NULL;
+}
+
+/**
+\brief Ocupa uma sessão do conjunto de um utilizador que ainda não tem sessão.
+
+É usada uma sessão livre, ou a sessão usada há mais tempo que não esteja presa, que é escrita
+no armazém caso tenha alterações.
+
+@param s Sessões.
+@param user Nome do utilizador.
+
+@returns A sessão, presa pelo processo e vazia, ou NULL caso nenhuma possa ser usada.
+*/
+static SESSAO *ocupa(SESSOES s, char *user)
+{
+	uint32_t m = marcar(user);
+	SESSAO *c = s->v + (m % NCONJUNTOS) * VIAS, *x = NULL;
+	int64_t min = 0;
+	int k, usado[VIAS] = {0};
+
+	for (k = 0; k < VIAS && x == NULL; k++)
+		if (atomic_load(&c[k].marca) == 0 && prende(c + k, 0))
+		{
+			if (atomic_load(&c[k].marca) == 0)
+				x = c + k;
+			else
+				solta(c + k);
+		}
+
+	while (x == NULL)
+	{
+		for (k = 0; k < VIAS; k++)
+			if (!usado[k] && (x == NULL || atomic_load(&c[k].uso) < min))
+			{
+				x = c + k;
+				min = atomic_load(&x->uso);
+			}
+		if (x == NULL)
+			return NULL;
+		usado[x - c] = 1;
+		if (!prende(x, 0))
+			x = NULL;
+		else if (atomic_load(&x->marca) && x->sujo && s->guardar(s->ctx, x->user, x->dados, x->tam))
+		{
+			solta(x);
+			x = NULL;
+		}
+	}
+
+	x->sujo = 0;
+	x->tam = 0;
+	strcpy(x->user, user);
+	atomic_store(&x->marca, m);
+	return x;
+}
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Abre as sessões, criando o segmento de memória partilhada caso ainda não exista.
+
+@param guardar Função que escreve uma sessão no armazém.
+@param ctx Contexto de @c guardar .
+
+@returns As sessões, ou NULL caso o segmento não possa ser usado.
+*/
+SESSOES abreS(GUARDAR guardar, void *ctx)
+{
+	SESSOES s;
+	struct stat st;
+	void *v;
+	int fd = shm_open(SESSOES_NOME, O_RDWR | O_CREAT, 0600);
+
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) || (st.st_size == 0 && ftruncate(fd, TAM_SEGMENTO)) ||
+		(st.st_size != 0 && (size_t)st.st_size != TAM_SEGMENTO))
+	{
+		close(fd);
+		return NULL;
+	}
+	v = mmap(NULL, TAM_SEGMENTO, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (v == MAP_FAILED)
+		return NULL;
+
+	s = malloc(sizeof(struct sessoes));
+	s->v = v;
+	s->guardar = guardar;
+	s->ctx = ctx;
+	return s;
+}
+
+/**
+\brief Fecha as sessões. O segmento de memória partilhada, e as sessões que este tem, mantêm-se.
+
+@param s Sessões.
+*/
+void fechaS(SESSOES s)
+{
+	munmap(s->v, TAM_SEGMENTO);
+	free(s);
+}
+
+/**
+\brief Lê o registo da sessão de um utilizador.
+
+@param s Sessões.
+@param user Nome do utilizador.
+@param tam Onde é colocado o tamanho do registo.
+
+@returns Uma cópia do registo, que deve ser libertada com @c free , ou NULL caso o utilizador não tenha sessão.
+*/
+char *leS(SESSOES s, char *user, size_t *tam)
+{
+	SESSAO *x = procura(s, user);
+	char *buf;
+
+	if (x == NULL)
+		return NULL;
+	*tam = x->tam;
+	buf = malloc(*tam + 1);
+	memcpy(buf, x->dados, *tam);
+	atomic_store(&x->uso, agora());
+	solta(x);
+	return buf;
+}
+
+/**
+\brief Escreve o registo da sessão de um utilizador.
+
+Caso o registo não caiba numa sessão, a sessão do utilizador é removida.
+
+@param s Sessões.
+@param user Nome do utilizador.
+@param buf Registo.
+@param tam Tamanho do registo.
+@param insere Diferente de 0 para ocupar uma sessão caso o utilizador ainda não a tenha.
+@param sujo Diferente de 0 caso o registo ainda não esteja escrito no armazém.
+
+@returns 0 se o registo ficou na sessão, -1 caso contrário, devendo então ser escrito no armazém.
+*/
+int escreveS(SESSOES s, char *user, const char *buf, size_t tam, int insere, int sujo)
+{
+	SESSAO *x;
+
+	if (tam > SESSOES_REGISTO || strlen(user) >= MAX_NOME)
+	{
+		removeS(s, user);
+		return -1;
+	}
+	if ((x = procura(s, user)) == NULL && (!insere || (x = ocupa(s, user)) == NULL))
+		return -1;
+
+	memcpy(x->dados, buf, tam);
+	x->tam = tam;
+	if (sujo && !x->sujo)
+		x->desde = agora();
+	x->sujo |= sujo;
+	atomic_store(&x->uso, agora());
+	solta(x);
+	return 0;
+}
+
+/**
+\brief Remove a sessão de um utilizador, sem a escrever no armazém.
+
+@param s Sessões.
+@param user Nome do utilizador.
+*/
+void removeS(SESSOES s, char *user)
+{
+	SESSAO *x = procura(s, user);
+	if (x)
+	{
+		atomic_store(&x->marca, 0);
+		x->sujo = 0;
+		solta(x);
+	}
+}
+
+/**
+\brief Escreve no armazém as sessões alteradas há pelo menos @p atraso segundos.
+
+As sessões presas por outros processos são ignoradas.
+
+@param s Sessões.
+@param atraso Número de segundos, 0 para escrever todas as sessões alteradas.
+*/
+void varreS(SESSOES s, int atraso)
+{
+	int64_t t = agora();
+	SESSAO *x;
+	int k;
+
+	for (k = 0, x = s->v; k < NCONJUNTOS * VIAS; k++, x++)
+		if (atomic_load(&x->marca) && prende(x, 0))
+		{
+			if (atomic_load(&x->marca) && x->sujo && t - x->desde >= atraso &&
+				!s->guardar(s->ctx, x->user, x->dados, x->tam))
+				x->sujo = 0;
+			solta(x);
+		}
+}
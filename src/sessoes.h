@@ -0,0 +1,55 @@
+/**
+*@file sessoes.h
+\brief Módulo das SESSOES, a cache dos utilizadores ativos em memória partilhada entre processos.
+*/
+#ifndef SESSOES_H
+#define SESSOES_H
+
+#include <stddef.h>
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Declaração da Estrutura principal.
+*/
+typedef struct sessoes* SESSOES;
+
+/**
+\brief Nome do segmento de memória partilhada das sessões.
+*/
+#define SESSOES_NOME "/GandaGalo"
+
+/**
+\brief Número de segundos que uma sessão alterada pode ficar por escrever no armazém.
+*/
+#define SESSOES_ATRASO 30
+
+/**
+\brief Tamanho máximo do registo de uma sessão. Os utilizadores com registos maiores não ficam em cache.
+*/
+#define SESSOES_REGISTO (65536 - 128)
+
+/**
+\brief Função que escreve no armazém o registo de uma sessão, antes de esta ser descartada
+ou quando passam @c SESSOES_ATRASO segundos desde que foi alterada.
+
+Recebe o contexto passado a @c abreS , o utilizador, o registo e o seu tamanho,
+devolvendo 0 em caso de sucesso.
+*/
+typedef int (*GUARDAR)(void *ctx, char *user, char *buf, size_t tam);
+
+// ------------------------------------------------------------------------------
+
+SESSOES abreS (GUARDAR guardar, void * ctx);
+
+void fechaS (SESSOES s);
+
+char * leS (SESSOES s, char * user, size_t * tam);
+
+int escreveS (SESSOES s, char * user, const char * buf, size_t tam, int insere, int sujo);
+
+void removeS (SESSOES s, char * user);
+
+void varreS (SESSOES s, int atraso);
+
+#endif
@@ -6,11 +6,11 @@
 #include "estado.h"
 #include "state.h"
 #include "decide.h"
-#include "stack.h"
+#include "historia.h"
 #include "filemanager.h"
 #include "solver.h"
 #include "frontend.h"
-#include "validate.h"
+#include "leaderboard.h"
 #include <string.h>
 
 // ------------------------------------------------------------------------------
@@ -22,8 +22,9 @@ void makefixo(ESTADO e);
 void increase(ESTADO e, int ox, int oy);
 void safedraw(ESTADO e);
 int victory(ESTADO e);
-int saveAnc(ESTADO e);
-void pop_Anc(ESTADO e);
+int saveAnc(ESTADO e, char * nome);
+void pop_Anc(ESTADO e, char * nome);
+void changeBranch(ESTADO e);
 int validTab (ESTADO e);
 
 /* Metódos privados */
@@ -160,65 +161,47 @@ void safedraw(ESTADO e)
 }
 
 /**
-\brief Função que transfere um elemento entre as stacks do estado.
+\brief Função que desfaz ou refaz uma jogada.
 
-A função efetua um @c pop da stack obtida por @c getE_stack segundo @p c , e de seguida efetua um push 
-que coloca o elemento retirado desta primeira na contra-parte. Por exemplo se @p c for 0 , então é efetuado @c pop 
-em @c passado e @c push em futuro.
+A função move o nó atual da @c HISTORIA do estado para o seu pai, se @p c for 0 , ou para o filho
+seguido pelo redo, caso contrário, e altera a posição correspondente na grelha.
 
-@param e Estado onde se encontra a stack a alterar.
-@param c indicador da primeira stack a alterar stack a alterar.
+@param e Estado a alterar.
+@param c 0 para undo, diferente de 0 para redo.
 
-@see pop
-@see push
-@see getE_stack
-@see estado::passado
-@see estado::futuro
+@see recuar
+@see avancar
+@see getE_hist
 */
 void pipestack(ESTADO e, int c)
 {
 	int i, j;
-	char val, flag;
-	val = pop(getE_stack(e, c), &i, &j, &flag);
-	if (val != -1)
-	{
-		push(getE_stack(e, !c), i, j, getE_elem(e, i, j));
+	char val;
+	if (c == 0 ? recuar(getE_hist(e), &i, &j, &val) : avancar(getE_hist(e), &i, &j, &val))
 		setE_elem(e, i, j, val);
-	}
-}
-
-/**
-\brief Verifica se a peça dada não é vazia.
-
-@param e Estado onde se encontra o tabuleiro.
-@param i Linha da Peca
-@param j Coluna da Peca
-
-@returns 0 se for VAZIA, 1 caso contrário.
-*/
-int is_not_solto (ESTADO e, int i, int j)
-{
-	return (getE_elem(e,i,j) != VAZIA);
 }
 
 /**
 \brief Função que verifica se o tabuleiro não tem peças vazias.
 
 Visto que o Jogo não permite o utilizador colocar três peças iguais em linha, para verificar se um mapa está completo, basta verificar se nãoexistem espaços em branco.
+O número de peças vazias é mantido pelo @c ESTADO, pelo que a verificação é feita em tempo constante.
+Em caso de vitória, o novo número de vitórias é passado para a leaderboard, que só é escrita aqui.
 
 @param e apontador para o estado a verificar.
 
 @returns 1 se todas peças forem diferentes de vazia, caso contrário devolve 0.
 
-@see is_not_solto
-@see getE_verf
+@see getE_vazias
+@see win_info
 */
 int victory(ESTADO e)
 {
-	int r = getE_verf(e,is_not_solto);
+	int r = (getE_vazias(e) == 0);
 	if (r){
 		setE_menu(e,VICTORY);
 		setE_wins(e,getE_wins(e)+1);
+		win_info(getE_user(e),getE_wins(e));
 	}
 	return r;
 }
@@ -226,58 +209,75 @@ int victory(ESTADO e)
 /**
 \brief Verifica se um tabuleiro é válido.
 
+O número de trios inválidos é mantido pelo @c ESTADO, pelo que a verificação é feita em tempo constante.
+
 @param e Estado a verificar.
 
 @returns 1 se o tabuleiro for válido, 0 caso contrário.
 
-@see valtab
-@see getE_verf
+@see getE_conflitos
 */
 int validTab (ESTADO e)
 {
-	return (getE_verf(e,valtab));
+	return (getE_conflitos(e) == 0);
 }
 
 /**
 \brief Função que guarda uma âncora.
 
 @param e Estado a modificar.
+@param nome Nome da âncora, NULL para uma âncora sem nome.
 
 @returns 1 se não ocorrerem erros, caso contrário devolve 0.
 
 @see makeAnc
-@see getE_stack
-@see estado::passado
+@see getE_hist
 */
-int saveAnc(ESTADO e) {
-	return (makeAnc(getE_stack(e, 0)));
+int saveAnc(ESTADO e, char * nome) {
+	return (makeAnc(getE_hist(e), nome));
 }
 
 /**
-\brief Função que carrega a última âncora
+\brief Função que carrega uma âncora
 
-Verifica se há alguma posição na @c STACK que corresponda a um valor com âncora, e se 
-existir faz pops sucessivos até alcançar este ponto. Colocando todos os elementos retirados da @c STACK @c passado em 
-@c futuro .
+A âncora pode estar em qualquer ramo da @c HISTORIA . São desfeitas as jogadas até ao antecessor comum
+do nó atual e do nó ancorado, e refeitas as jogadas daí até à âncora, em tempo proporcional à profundidade
+dos nós. As âncoras sem nome são removidas ao serem carregadas, as âncoras com nome são mantidas para que
+se possa voltar a elas.
 
-@param e apontador para o estado a verificar
+@param e apontador para o estado a alterar
+@param nome Nome da âncora, NULL para carregar a última âncora.
 
-@see canGetAnc
-@see peek
-@see pop
-@see push
-@see estado::passado
-@see estado::futuro
+@see findAnc
+@see apontar
+@see pipestack
 */
-void pop_Anc(ESTADO e)
+void pop_Anc(ESTADO e, char * nome)
 {
-	char flag, r;
-	int i, j;
-	STACK past = getE_stack(e,0);
-	while (canGetAnc(past) && !peek(past) )
-	{
-		r = pop(past, &i, &j, &flag);
-		push(getE_stack(e, 1), i, j, getE_elem(e, i, j));
-		setE_elem(e, i, j, r);
-	}
+	int sobe, desce;
+	HISTORIA h = getE_hist(e);
+	int k = findAnc(h, nome);
+	if (k < 0)
+		return;
+	apontar(h, getAnc_no(h, k), &sobe, &desce);
+	while (sobe-- > 0)
+		pipestack(e, 0);
+	while (desce-- > 0)
+		pipestack(e, 1);
+	if (!getAnc_nome(h, k)[0])
+		removeAnc(h, k);
+}
+
+/**
+\brief Função que altera o ramo seguido pelo redo.
+
+Quando existem várias jogadas feitas a partir do tabuleiro atual, o redo passa a seguir a próxima.
+
+@param e apontador para o estado a alterar
+
+@see outroRamo
+*/
+void changeBranch(ESTADO e)
+{
+	outroRamo(getE_hist(e));
 }
@@ -22,9 +22,11 @@ void pipestack (ESTADO e, int c);
 
 int victory(ESTADO e);
 
-int saveAnc(ESTADO e);
+int saveAnc(ESTADO e, char * nome);
 
-void pop_Anc(ESTADO e);
+void pop_Anc(ESTADO e, char * nome);
+
+void changeBranch(ESTADO e);
 
 int validTab (ESTADO e);
 
@@ -3,9 +3,14 @@
 \brief Módulo para conversão entre ficheiros e ESTADO
 */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "userfiles.h"
-#include "stack.h"
+#include "historia.h"
 #include "estado.h"
+#include "state.h"
+#include "armazem.h"
+#include "sessoes.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -13,20 +18,688 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/wait.h>
+#include <stdint.h>
 
 // ------------------------------------------------------------------------------
 
 /* Metódos públicos */
 void estado2file_un(char *path, char *user, ESTADO e);
 ESTADO file2estado_un(char *path, char *user, int *flag);
+void estado2bin_un(char *path, char *user, ESTADO e);
+ESTADO bin2estado_un(char *path, char *user, int *flag);
+void estado2jnl_un(char *path, char *user, ESTADO e);
+void trancaUser_un(char *path, char *user, int exclusivo);
+void varreSessoes_un(char *path, int atraso);
 
 /* Metódos privados */
-static STACK readAll(FILE *fp);
+static int readTuplo(FILE *fp, int *v, int max);
+static void readNos(FILE *fp, HISTORIA h);
+static void readAnc(FILE *fp, HISTORIA h, int desvio);
+static int *readRegistos(FILE *fp, int *n);
+static int readLegado(FILE *fp, ESTADO e);
+static int readHistoria(FILE *fp, HISTORIA h);
+static char *caminho(char *path, char *user, char *ext);
+static void aplicaJournal(const char *buf, size_t tam, ESTADO e);
+static int leNos(void *ctx, size_t off, size_t tam, char *buf);
+static char *registo(ESTADO e, size_t *tam);
+static int escreveRegisto(char *path, char *user, char *buf, size_t tam);
+static int guardaSessao(void *ctx, char *user, char *buf, size_t tam);
+static SESSOES sessoesUsers(char *path);
+static int mudou(ESTADO e, int *ncel);
 
 // ------------------------------------------------------------------------------
 
 /**
-\brief Escreve um estado para ficheiro.
+\brief Identificador no início de um ficheiro binário de utilizador.
+*/
+#define BIN_MAGIC "GGSV"
+
+/**
+\brief Versão do formato binário de utilizador.
+*/
+#define BIN_VERSAO 1
+
+/**
+\brief Extensão dos registos binários de utilizador, usada nas chaves do @c ARMAZEM .
+*/
+#define BIN_EXT ".sav"
+
+/**
+\brief Cabeçalho de tamanho fixo de um ficheiro binário de utilizador.
+
+O ficheiro é composto pelo cabeçalho, pela grelha, guardada numa zona fixa de
+@c MAX_GRID x @c MAX_GRID bytes, e pela forma binária da @c HISTORIA , que fica assim alinhada.
+Os valores são guardados na ordem de bytes da máquina.
+*/
+typedef struct cabecalho
+{
+	char magic[4];           /**< BIN_MAGIC */
+	int32_t versao;          /**< BIN_VERSAO */
+	int32_t lins;            /**< Número de linhas */
+	int32_t cols;            /**< Número de colunas */
+	int32_t flag;            /**< Flag */
+	int32_t menu;            /**< Menu atual */
+	int32_t help;            /**< Número restante de hints */
+	int32_t wins;            /**< Número de vitórias */
+	int32_t nnos;            /**< Número de nós da história */
+	int32_t atual;           /**< Nó atual da história */
+	int32_t nanc;            /**< Número de âncoras */
+	char user[MAX_USER];     /**< Nome de utilizador */
+	int32_t geracao;         /**< Número de vezes que o ficheiro foi reescrito */
+} CABECALHO;
+
+/**
+\brief Extensão dos journals de utilizador, usada nas chaves do @c ARMAZEM .
+*/
+#define JNL_EXT ".jnl"
+
+/**
+\brief Cabeçalho de um registo do journal de um utilizador.
+
+Cada pedido que altera o estado acrescenta ao journal um registo com os campos do estado,
+as posições da grelha alteradas e as alterações da @c HISTORIA . Todos os valores são absolutos,
+pelo que aplicar um registo mais de uma vez não altera o resultado.
+Os registos de uma geração diferente da do ficheiro binário são ignorados, para que um journal
+que ficou por apagar não se sobreponha a um ficheiro binário mais recente.
+*/
+typedef struct registo
+{
+	int32_t tam;             /**< Tamanho total do registo, em bytes */
+	int32_t geracao;         /**< Geração do ficheiro binário a que o registo se aplica */
+	int32_t lins;            /**< Número de linhas */
+	int32_t cols;            /**< Número de colunas */
+	int32_t flag;            /**< Flag */
+	int32_t menu;            /**< Menu atual */
+	int32_t help;            /**< Número restante de hints */
+	int32_t wins;            /**< Número de vitórias */
+	int32_t ncel;            /**< Número de posições da grelha alteradas */
+} REGISTO;
+
+/**
+\brief Posição da grelha alterada, num registo do journal.
+*/
+typedef struct celula
+{
+	unsigned char i;         /**< Linha */
+	unsigned char j;         /**< Coluna */
+	unsigned char val;       /**< Novo valor */
+	unsigned char pad;       /**< Alinhamento */
+} CELULA;
+
+/**
+\brief Origem dos nós de uma @c HISTORIA lida do @c ARMAZEM , que só são lidos quando são precisos.
+
+@see leNos
+*/
+typedef struct fonte
+{
+	char chave[MAX_CHAVE];   /**< Chave do registo binário do utilizador */
+	size_t inicio;           /**< Posição dos nós no registo */
+	char path[];             /**< Diretória onde se encontram os users */
+} FONTE;
+
+/**
+\brief Cópia do estado tal como foi lido, usada para calcular o registo a acrescentar ao journal.
+*/
+static ESTADO carregado = NULL;
+
+/**
+\brief Utilizador a que corresponde @c carregado .
+*/
+static char userCarregado[MAX_USER];
+
+/**
+\brief Tamanho do journal quando @c carregado foi lido.
+*/
+static size_t tamJournal = 0;
+
+/**
+\brief Geração do ficheiro binário de que @c carregado foi lido.
+*/
+static int32_t geracao = 0;
+
+/**
+\brief Indica se @c carregado foi lido das @c SESSOES , e não do armazém.
+*/
+static int daSessao = 0;
+
+/**
+\brief Indica se o pedido tem a tranca exclusiva do utilizador, podendo ocupar uma sessão.
+*/
+static int pedidoExclusivo = 0;
+
+/**
+\brief Sessões abertas por @c sessoesUsers .
+*/
+static SESSOES sessoes = NULL;
+
+/**
+\brief Diretória dos users usada por @c sessoes para escrever no armazém.
+*/
+static char *pathSessoes = NULL;
+
+// ------------------------------------------------------------------------------
+
+/**
+\brief Cria o caminho para o ficheiro de um utilizador.
+
+@param path String correspondente à diretória onde se encontram os users.
+@param user Nome do utilizador.
+@param ext Extensão do ficheiro.
+
+@returns O caminho, que deve ser libertado com @c free .
+*/
+static char *caminho(char *path, char *user, char *ext)
+{
+	char *aux = (char *)malloc(sizeof(char) * (strlen(path) + strlen(user) + strlen(ext) + 1));
+	sprintf(aux, "%s%s%s", path, user, ext);
+	return aux;
+}
+
+/**
+\brief Lê parte dos nós da @c HISTORIA de um utilizador, a partir do seu registo binário no @c ARMAZEM .
+
+@param ctx A @c FONTE dos nós.
+@param off Posição, na forma binária dos nós, do primeiro byte a ler.
+@param tam Número de bytes a ler.
+@param buf Onde são colocados os bytes lidos.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+
+@see lerAdiadoH
+*/
+static int leNos(void *ctx, size_t off, size_t tam, char *buf)
+{
+	FONTE *f = (FONTE *)ctx;
+	ARMAZEM a = armazem(f->path);
+	return a ? leParteA(a, f->chave, f->inicio + off, buf, tam, NULL) : -1;
+}
+
+/**
+\brief Monta o registo binário de um estado.
+
+@param e Estado.
+@param tam Onde é colocado o tamanho do registo.
+
+@returns O registo, que deve ser libertado com @c free .
+
+@see CABECALHO
+@see copiaH
+*/
+static char *registo(ESTADO e, size_t *tam)
+{
+	HISTORIA h = getE_hist(e);
+	CABECALHO *cab;
+	char *buf;
+	int i, j;
+
+	*tam = sizeof(CABECALHO) + MAX_GRID * MAX_GRID + tamH(nNos(h), nAnc(h));
+	buf = calloc(1, *tam);
+	cab = (CABECALHO *)buf;
+	memcpy(cab->magic, BIN_MAGIC, 4);
+	cab->versao = BIN_VERSAO;
+	cab->lins = getE_lins(e);
+	cab->cols = getE_cols(e);
+	cab->flag = getE_flag(e);
+	cab->menu = getE_menu(e);
+	cab->help = getE_help(e);
+	cab->wins = getE_wins(e);
+	cab->nnos = nNos(h);
+	cab->atual = getH_atual(h);
+	cab->nanc = nAnc(h);
+	strncpy(cab->user, getE_user(e), MAX_USER - 1);
+	for (i = 0; i < cab->lins; i++)
+		for (j = 0; j < cab->cols; j++)
+			buf[sizeof(CABECALHO) + i * MAX_GRID + j] = getE_elem(e, i, j);
+	copiaH(h, buf + sizeof(CABECALHO) + MAX_GRID * MAX_GRID);
+	return buf;
+}
+
+/**
+\brief Escreve um registo binário no @c ARMAZEM dos utilizadores, substituindo o journal.
+
+A geração do registo é incrementada, o que invalida os registos do journal anterior caso este
+não chegue a ser apagado. Do registo anterior só é lido o cabeçalho, com @c leParteA .
+
+@param path String correspondente à diretória onde se encontram os users.
+@param user String correspondente ao nome do utilizador.
+@param buf Registo, montado com @c registo .
+@param tam Tamanho do registo.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+
+@see leParteA
+@see escreveA
+*/
+static int escreveRegisto(char *path, char *user, char *buf, size_t tam)
+{
+	ARMAZEM a = armazem(path);
+	CABECALHO *cab = (CABECALHO *)buf, ant;
+	char *aux;
+	int r;
+
+	if (a == NULL)
+		return -1;
+	cab->geracao = 0;
+	aux = caminho("", user, BIN_EXT);
+	if (!leParteA(a, aux, 0, (char *)&ant, sizeof(CABECALHO), NULL) && !memcmp(ant.magic, BIN_MAGIC, 4) && ant.versao == BIN_VERSAO)
+		cab->geracao = ant.geracao + 1;
+	r = escreveA(a, aux, buf, tam);
+	free(aux);
+	if (r)
+		return -1;
+
+	aux = caminho("", user, JNL_EXT);
+	apagaA(a, aux);
+	free(aux);
+	return 0;
+}
+
+/**
+\brief Escreve no armazém o registo de uma sessão.
+
+@param ctx Diretória onde se encontram os users.
+@param user Nome do utilizador.
+@param buf Registo da sessão.
+@param tam Tamanho do registo.
+
+@returns 0 em caso de sucesso, -1 caso contrário.
+
+@see GUARDAR
+*/
+static int guardaSessao(void *ctx, char *user, char *buf, size_t tam)
+{
+	return escreveRegisto((char *)ctx, user, buf, tam);
+}
+
+/**
+\brief Devolve as sessões dos utilizadores de uma diretória, abrindo-as na primeira utilização.
+
+@param path Diretória onde se encontram os users.
+
+@returns As sessões, ou NULL caso não possam ser usadas.
+*/
+static SESSOES sessoesUsers(char *path)
+{
+	if (sessoes && strcmp(pathSessoes, path))
+	{
+		fechaS(sessoes);
+		free(pathSessoes);
+		sessoes = NULL;
+	}
+	if (sessoes == NULL)
+	{
+		pathSessoes = strdup(path);
+		if ((sessoes = abreS(guardaSessao, pathSessoes)) == NULL)
+		{
+			free(pathSessoes);
+			pathSessoes = NULL;
+		}
+	}
+	return sessoes;
+}
+
+/**
+\brief Escreve um estado em formato binário, no @c ARMAZEM dos utilizadores.
+
+O registo é montado em memória e escrito de uma só vez, e o journal do utilizador é apagado.
+A sessão do utilizador, caso exista, é removida, pois deixa de corresponder ao armazém.
+
+@param path String correspondente à diretória onde se encontram os users.
+@param user String correspondente ao nome do utilizador.
+@param e Apontador para o estado que irá ser guardado.
+
+@see registo
+@see escreveRegisto
+*/
+void estado2bin_un(char *path, char *user, ESTADO e)
+{
+	SESSOES s = sessoesUsers(path);
+	size_t tam;
+	char *buf;
+
+	if (s)
+		removeS(s, user);
+	buf = registo(e, &tam);
+	escreveRegisto(path, user, buf, tam);
+	free(buf);
+}
+
+/**
+\brief Aplica a um estado os registos do journal de um utilizador.
+
+A leitura pára no primeiro registo incompleto ou inválido.
+Caso existam registos de outra geração, o journal é reescrito no próximo pedido.
+
+@param buf Conteúdo do journal, ou NULL caso não exista.
+@param tam Tamanho do journal.
+@param e Estado lido do registo binário do utilizador.
+
+@see estado2jnl_un
+@see aplicaDeltaH
+*/
+static void aplicaJournal(const char *buf, size_t tam, ESTADO e)
+{
+	REGISTO r;
+	CELULA *c;
+	size_t off = 0, tamCel;
+	int k;
+
+	tamJournal = buf ? tam : 0;
+	while (buf && off + sizeof(REGISTO) <= tam)
+	{
+		memcpy(&r, buf + off, sizeof(REGISTO));
+		tamCel = sizeof(CELULA) * (size_t)r.ncel;
+		if (r.tam % 4 || r.ncel < 0 || (size_t)r.tam < sizeof(REGISTO) + tamCel || off + r.tam > tam ||
+			r.lins < 0 || r.lins > MAX_GRID || r.cols < 0 || r.cols > MAX_GRID)
+			break;
+		if (r.geracao != geracao)
+		{
+			tamJournal = JNL_MAX;
+			off += r.tam;
+			continue;
+		}
+		if (!aplicaDeltaH(getE_hist(e), buf + off + sizeof(REGISTO) + tamCel, r.tam - sizeof(REGISTO) - tamCel))
+			break;
+		setE_lins(e, r.lins);
+		setE_cols(e, r.cols);
+		setE_flag(e, r.flag);
+		setE_menu(e, r.menu);
+		setE_help(e, r.help);
+		setE_wins(e, r.wins);
+		c = (CELULA *)(buf + off + sizeof(REGISTO));
+		for (k = 0; k < r.ncel; k++)
+			setE_elem(e, c[k].i, c[k].j, c[k].val);
+		off += r.tam;
+	}
+}
+
+/**
+\brief Compara um estado com @c carregado .
+
+@param e Estado.
+@param ncel Onde é colocado o número de posições da grelha alteradas.
+
+@returns Diferente de 0 caso o estado tenha sido alterado.
+*/
+static int mudou(ESTADO e, int *ncel)
+{
+	int i, j;
+
+	*ncel = 0;
+	for (i = 0; i < getE_lins(e); i++)
+		for (j = 0; j < getE_cols(e); j++)
+			*ncel += (getE_elem(e, i, j) != getE_elem(carregado, i, j));
+
+	return *ncel || mudouH(getE_hist(e)) || getE_lins(e) != getE_lins(carregado) || getE_cols(e) != getE_cols(carregado) ||
+		getE_flag(e) != getE_flag(carregado) || getE_menu(e) != getE_menu(carregado) ||
+		getE_help(e) != getE_help(carregado) || getE_wins(e) != getE_wins(carregado);
+}
+
+/**
+\brief Guarda as alterações de um estado desde que foi lido.
+
+Caso o utilizador tenha sessão, ou o pedido tenha a tranca exclusiva, o registo binário completo é
+escrito nas @c SESSOES , e só chega ao armazém quando a sessão é descartada ou passados
+@c SESSOES_ATRASO segundos, por @c varreSessoes_un . Caso contrário, é acrescentado um registo ao journal do utilizador
+no @c ARMAZEM , pelo que o custo de guardar não depende do tamanho da história. Se o estado não foi
+lido do armazém, ou se o journal já ultrapassou @c JNL_MAX bytes, é escrito o registo binário completo,
+que substitui o journal. Se nada mudou, nada é escrito.
+
+@param path String correspondente à diretória onde se encontram os users.
+@param user String correspondente ao nome do utilizador.
+@param e Apontador para o estado que irá ser guardado.
+
+@see REGISTO
+@see copiaDeltaH
+@see estado2bin_un
+@see acrescentaA
+@see escreveS
+@see varreSessoes_un
+*/
+void estado2jnl_un(char *path, char *user, ESTADO e)
+{
+	HISTORIA h = getE_hist(e);
+	SESSOES s = sessoesUsers(path);
+	ARMAZEM a;
+	REGISTO *r;
+	CELULA *c;
+	char *buf, *aux;
+	size_t tam;
+	int i, j, ncel = 0, emSessao = 0;
+	int novo = (carregado == NULL || strcmp(userCarregado, user));
+	int alterado = novo || mudou(e, &ncel);
+
+	if (s && (daSessao || pedidoExclusivo) && (alterado || !daSessao) &&
+		sizeof(CABECALHO) + MAX_GRID * MAX_GRID + tamH(nNos(h), nAnc(h)) <= SESSOES_REGISTO)
+	{
+		buf = registo(e, &tam);
+		emSessao = !escreveS(s, user, buf, tam, pedidoExclusivo, alterado);
+		free(buf);
+	}
+
+	if (emSessao || !alterado)
+		;
+	else if (novo || daSessao || tamJournal >= JNL_MAX)
+		estado2bin_un(path, user, e);
+	else
+	{
+		tam = sizeof(REGISTO) + sizeof(CELULA) * ncel + tamDeltaH(h);
+		buf = calloc(1, tam);
+		r = (REGISTO *)buf;
+		r->tam = tam;
+		r->geracao = geracao;
+		r->lins = getE_lins(e);
+		r->cols = getE_cols(e);
+		r->flag = getE_flag(e);
+		r->menu = getE_menu(e);
+		r->help = getE_help(e);
+		r->wins = getE_wins(e);
+		r->ncel = ncel;
+		c = (CELULA *)(buf + sizeof(REGISTO));
+		for (i = 0; i < getE_lins(e); i++)
+			for (j = 0; j < getE_cols(e); j++)
+				if (getE_elem(e, i, j) != getE_elem(carregado, i, j))
+				{
+					c->i = i;
+					c->j = j;
+					c->val = getE_elem(e, i, j);
+					c++;
+				}
+		copiaDeltaH(h, (char *)c);
+
+		aux = caminho("", user, JNL_EXT);
+		if ((a = armazem(path)) != NULL)
+			acrescentaA(a, aux, buf, tam);
+		free(aux);
+		free(buf);
+	}
+
+	if (carregado)
+		destroyState(carregado);
+	carregado = NULL;
+	daSessao = 0;
+}
+
+/**
+\brief Escreve no @c ARMAZEM as sessões dos utilizadores alteradas há pelo menos @p atraso segundos.
+
+É chamada no fim de cada pedido, e pelo programa @b descarregar , para que as alterações de um
+utilizador que deixou de jogar não fiquem só em memória.
+
+@param path String correspondente à diretória onde se encontram os users.
+@param atraso Número de segundos, 0 para escrever todas as sessões alteradas.
+
+@see varreS
+*/
+void varreSessoes_un(char *path, int atraso)
+{
+	SESSOES s = sessoesUsers(path);
+	if (s)
+		varreS(s, atraso);
+}
+
+/**
+\brief Passa o registo binário de um utilizador para Estado.
+
+Caso o utilizador tenha sessão, o registo é copiado das @c SESSOES , sem acesso ao disco,
+e o journal não é aplicado, pois a sessão já o inclui.
+Caso contrário, do registo no @c ARMAZEM dos utilizadores são lidos apenas o cabeçalho, a grelha e as âncoras,
+copiados para o estado sem interpretação de texto. Os nós da @c HISTORIA só são lidos quando são precisos,
+pelo que o custo de um pedido não depende do tamanho da história.
+Caso o utilizador ainda não esteja no armazém, é lido o ficheiro de texto antigo,
+e o estado é passado para o armazém no próximo pedido.
+Caso contrário, são aplicados os registos do journal do utilizador, e é guardada uma cópia
+do estado lido, a partir da qual @c estado2jnl_un calcula o próximo registo.
+
+@param path String correspondente à diretória onde se encontram os users.
+@param user String correspondente ao nome do utilizador que irá ser lido.
+@param flag Apontador para o inteiro onde irá ser colocado o valor da validade do registo.
+
+@returns O Estado obtido.
+
+@see file2estado_un
+@see lerH
+@see lerAdiadoH
+@see leParteA
+@see leS
+*/
+ESTADO bin2estado_un(char *path, char *user, int *flag)
+{
+	ESTADO e;
+	HISTORIA h = NULL;
+	CABECALHO *cab;
+	ARMAZEM a = armazem(path);
+	SESSOES s = sessoesUsers(path);
+	FONTE *f = NULL;
+	char *buf = NULL, *anc, *aux;
+	size_t tam;
+	int i, j;
+
+	daSessao = 0;
+	if (s && (buf = leS(s, user, &tam)) != NULL)
+		daSessao = 1;
+	else if (a)
+	{
+		f = malloc(sizeof(FONTE) + strlen(path) + 1);
+		snprintf(f->chave, MAX_CHAVE, "%s%s", user, BIN_EXT);
+		strcpy(f->path, path);
+		f->inicio = sizeof(CABECALHO) + MAX_GRID * MAX_GRID;
+		buf = malloc(f->inicio);
+		if (leParteA(a, f->chave, 0, buf, f->inicio, &tam))
+		{
+			free(buf);
+			free(f);
+			buf = NULL;
+			f = NULL;
+		}
+	}
+	if (buf == NULL)
+		return file2estado_un(path, user, flag);
+
+	e = makeState(NULL);
+	*flag = 0;
+	cab = (CABECALHO *)buf;
+	if (tam >= sizeof(CABECALHO) + MAX_GRID * MAX_GRID &&
+		!memcmp(cab->magic, BIN_MAGIC, 4) && cab->versao == BIN_VERSAO &&
+		cab->lins >= 0 && cab->lins <= MAX_GRID && cab->cols >= 0 && cab->cols <= MAX_GRID &&
+		cab->nnos > 0 && cab->nanc >= 0 &&
+		tam == sizeof(CABECALHO) + MAX_GRID * MAX_GRID + tamH(cab->nnos, cab->nanc))
+	{
+		if (daSessao)
+			h = lerH(buf + sizeof(CABECALHO) + MAX_GRID * MAX_GRID, cab->nnos, cab->nanc, cab->atual);
+		else
+		{
+			anc = malloc(tamH(0, cab->nanc) + 1);
+			if (!leParteA(a, f->chave, f->inicio + tamH(cab->nnos, 0), anc, tamH(0, cab->nanc), NULL))
+				h = lerAdiadoH(cab->nnos, cab->nanc, cab->atual, anc, leNos, f);
+			else
+				free(f);
+			f = NULL;
+			free(anc);
+		}
+	}
+	free(f);
+
+	if (h)
+	{
+		memcpy(getE_user(e), cab->user, MAX_USER - 1);
+		setE_lins(e, cab->lins);
+		setE_cols(e, cab->cols);
+		setE_flag(e, cab->flag);
+		setE_menu(e, cab->menu);
+		setE_help(e, cab->help);
+		setE_wins(e, cab->wins);
+		for (i = 0; i < cab->lins; i++)
+			for (j = 0; j < cab->cols; j++)
+				setE_elem(e, i, j, buf[sizeof(CABECALHO) + i * MAX_GRID + j]);
+		setE_hist(e, h);
+		geracao = cab->geracao;
+		*flag = 1;
+	}
+	free(buf);
+
+	if (daSessao && !*flag)
+	{
+		destroyState(e);
+		removeS(s, user);
+		return bin2estado_un(path, user, flag);
+	}
+
+	if (*flag)
+	{
+		if (daSessao)
+			buf = NULL;
+		else
+		{
+			aux = caminho("", user, JNL_EXT);
+			buf = leA(a, aux, &tam);
+			free(aux);
+		}
+		aplicaJournal(buf, tam, e);
+		free(buf);
+		marcaH(getE_hist(e));
+		if (carregado)
+			destroyState(carregado);
+		carregado = snapshotState(e);
+		strncpy(userCarregado, user, MAX_USER - 1);
+	}
+	return e;
+}
+
+/**
+\brief Tranca um utilizador até ao fim do pedido, para que pedidos simultâneos do mesmo
+utilizador não leiam um estado que está a ser alterado.
+
+Os pedidos que só leem o estado podem partilhar a tranca, enquanto que um pedido que o altera
+espera que todos os outros terminem, e só este pode ocupar uma sessão para o utilizador.
+A tranca é libertada por @c fechaArmazem . Caso o utilizador já esteja trancado pelo pedido, a tranca
+anterior é libertada antes de ser pedida a nova, para que dois pedidos que passem de uma tranca partilhada
+para uma exclusiva não fiquem à espera um do outro. O estado lido com a tranca anterior deve então ser lido de novo.
+
+@param path String correspondente à diretória onde se encontram os users.
+@param user Nome do utilizador.
+@param exclusivo Diferente de 0 caso o pedido altere o estado.
+
+@see trancaA
+@see destrancaA
+*/
+void trancaUser_un(char *path, char *user, int exclusivo)
+{
+	ARMAZEM a = armazem(path);
+	pedidoExclusivo = exclusivo;
+	if (a)
+	{
+		destrancaA(a, user);
+		trancaA(a, user, exclusivo);
+	}
+}
+
+/**
+\brief Escreve um estado para ficheiro de texto.
+
+O ficheiro é escrito num ficheiro temporário, que substitui o anterior com @c rename ,
+pelo que um leitor nunca encontra um ficheiro incompleto.
 
 @param path String correspondente à diretória onde se encontram os users.
 @param user String correspondente ao nome do ficheiro que irá ser guardado.
@@ -37,15 +710,17 @@ void estado2file_un(char *path, char *user, ESTADO e)
 	int l, c;
 	l = getE_lins(e);
 	c = getE_cols(e);
-	char *aux = (char *)malloc(sizeof(char) * (strlen(path) + strlen(user) + strlen(".txt") + 1));
-	sprintf(aux, "%s%s%s", path, user, ".txt");
+	char *aux = caminho(path, user, ".txt"), *tmp = caminho(path, user, ".txt.tmp");
 
-	char *fut, *past;
-	FILE *fp = fopen(aux, "w");
-	/// fclose(fp);
+	FILE *fp = fopen(tmp, "w");
 	int i, j;
-	chmod(aux, 0777);
-	free(aux);
+	if (fp == NULL)
+	{
+		free(aux);
+		free(tmp);
+		return;
+	}
+	chmod(tmp, 0777);
 
 	fprintf(fp, "USER: %s\n", getE_user(e));
 	fprintf(fp, "N_LINS: %d\n", l);
@@ -62,39 +737,210 @@ void estado2file_un(char *path, char *user, ESTADO e)
 		fprintf(fp, "\n");
 	}
 
-	past = completeS(getE_stack(e, 0));
-	fut = completeS(getE_stack(e, 1));
-	fprintf(fp, "PASSADO:%s\n", past);
-	fprintf(fp, "FUTURO:%s\n", fut);
+	fprintf(fp, "HISTORIA: %d %d\nNOS:", getH_atual(getE_hist(e)), getH_fim(getE_hist(e)));
+	writeNos(getE_hist(e), fp);
+	fprintf(fp, "\nANCORAS:");
+	writeAnc(getE_hist(e), fp);
+	fprintf(fp, "\n");
 
-	free(past);
-	free(fut);
+	if (fclose(fp) == 0)
+		rename(tmp, aux);
+	else
+		unlink(tmp);
+	free(aux);
+	free(tmp);
+}
 
-	fclose(fp);
+/**
+\brief Lê o próximo tuplo de inteiros da forma @b (a,b,...) de uma linha do ficheiro.
+
+A linha é lida carater a carater, sem ser copiada para um buffer. Quando o fim da linha é
+alcançado, este é consumido e é devolvido 0.
+
+@param fp Apontador para ficheiro apartir do qual se pretende ler o tuplo.
+@param v Array onde são colocados os valores do tuplo.
+@param max Número máximo de valores a ler.
+
+@returns O número de valores lidos, 0 se a linha terminou.
+*/
+static int readTuplo(FILE *fp, int *v, int max)
+{
+	int ch, campo = -1;
+	while ((ch = getc(fp)) != '\n' && ch != EOF)
+	{
+		if (ch == '(')
+			v[campo = 0] = 0;
+		else if (campo < 0)
+			continue;
+		else if (ch >= '0' && ch <= '9')
+			v[campo] = v[campo] * 10 + ch - '0';
+		else if (ch == ',' && campo < max - 1)
+			v[++campo] = 0;
+		else if (ch == ')')
+			return campo + 1;
+	}
+	return 0;
 }
 
 /**
-\brief Lê, enquanto for possível, os valores obtidos de uma Stream de ficheiro e cria uma stack correspondente.
+\brief Lê, até ao fim da linha, os nós de uma história e acrescenta-os à @c HISTORIA .
 
-@param fp Apontador para ficheiro apartir do qual se pretende começar a ler a stack.
+Os nós são da forma @b (i,j,velho,novo), com o pai no nó anterior, ou @b (i,j,velho,novo,d),
+com o pai @b d nós atrás.
 
-@returns A stack criada apartir do ficheiro passado como argumento.
+@param fp Apontador para ficheiro apartir do qual se pretende começar a ler os nós.
+@param h @c HISTORIA onde serão colocados os nós.
+
+@see writeNos
 */
-static STACK readAll(FILE *fp)
+static void readNos(FILE *fp, HISTORIA h)
 {
-	STACK stk;
-	stk = initS();
-	char aux[300];
-	int r, i, j, val, check;
-	char ch;
-	ch = fgetc(fp);
-	while ((r = fscanf(fp, "%s", aux)) != EOF && ch != '\n')
+	int v[5], n;
+	while ((n = readTuplo(fp, v, 5)) > 0)
+		if (n >= 4)
+			addNo(h, nNos(h) - (n == 5 ? v[4] : 1), v[0], v[1], v[2], v[3]);
+}
+
+/**
+\brief Lê as âncoras de uma linha do ficheiro e coloca-as na @c HISTORIA , substituindo as âncoras que esta tinha.
+
+As âncoras são da forma @b (no,nome) e são lidas carater a carater, tal como em readTuplo.
+
+@param fp Apontador para ficheiro apartir do qual se pretende começar a ler as âncoras.
+@param h @c HISTORIA onde serão colocadas as âncoras.
+@param desvio Valor a somar a cada nó lido. No formato antigo as âncoras indicam a posição do registo no passado, que corresponde ao nó seguinte.
+*/
+static void readAnc(FILE *fp, HISTORIA h, int desvio)
+{
+	char nome[MAX_ANC_NOME];
+	int ch, k = 0, n = -1;
+	clearAnc(h);
+	while ((ch = getc(fp)) != '\n' && ch != EOF)
+	{
+		if (ch == '(')
+		{
+			k = 0;
+			n = -1;
+		}
+		else if (ch == ')' && n >= 0)
+		{
+			nome[n] = '\0';
+			addAnc(h, k + desvio, strcmp(nome, "-") ? nome : NULL);
+			n = -1;
+		}
+		else if (n < 0 && ch == ',')
+			n = 0;
+		else if (n < 0 && ch >= '0' && ch <= '9')
+			k = k * 10 + ch - '0';
+		else if (n >= 0 && n < MAX_ANC_NOME - 1)
+			nome[n++] = ch;
+	}
+}
+
+/**
+\brief Lê, até ao fim da linha, os registos @b (i,j,val,check) do histórico no formato antigo.
+
+São ignorados os registos fora da grelha. Cada registo ocupa 5 posições do array devolvido,
+sendo a última reservada para o valor da posição depois da jogada.
+
+@param fp Apontador para ficheiro apartir do qual se pretende começar a ler os registos.
+@param n Apontador para onde será colocado o número de registos lidos.
+
+@returns O array de registos, que deve ser libertado com @c free .
+*/
+static int *readRegistos(FILE *fp, int *n)
+{
+	int cap = 16;
+	int *reg = malloc(sizeof(int) * 5 * cap);
+	*n = 0;
+	while (readTuplo(fp, &reg[5 * *n], 4) > 0)
+	{
+		if (reg[5 * *n] >= MAX_GRID || reg[5 * *n + 1] >= MAX_GRID)
+			continue;
+		if (++(*n) == cap)
+			reg = realloc(reg, sizeof(int) * 5 * (cap *= 2));
+	}
+	return reg;
+}
+
+/**
+\brief Lê o histórico no formato antigo, com as linhas @b PASSADO e @b FUTURO , e constroi a @c HISTORIA correspondente.
+
+Os registos do passado guardam apenas o valor anterior a cada jogada, pelo que as jogadas são
+primeiro desfeitas na grelha, do topo para a base, para obter os valores novos. De seguida são
+refeitas as jogadas do passado e do futuro, e desfeitas as do futuro, ficando o futuro como redo.
+Os registos marcados como âncoras dão origem a âncoras sem nome.
+
+@param fp Apontador para ficheiro, posicionado depois de @b PASSADO: .
+@param e Estado com a grelha lida do ficheiro.
+
+@returns 1 se o histórico foi lido, 0 caso contrário.
+*/
+static int readLegado(FILE *fp, ESTADO e)
+{
+	HISTORIA h = getE_hist(e);
+	int np, nf, k, *r, *past, *fut;
+	past = readRegistos(fp, &np);
+	if (fscanf(fp, "FUTURO:") == EOF)
+	{
+		free(past);
+		return 0;
+	}
+	fut = readRegistos(fp, &nf);
+
+	for (k = 0; k < np; k++)
+	{
+		r = &past[5 * k];
+		r[4] = getE_elem(e, r[0], r[1]);
+		setE_elem(e, r[0], r[1], r[2]);
+	}
+	for (k = np - 1; k >= 0; k--)
+	{
+		r = &past[5 * k];
+		jogada(h, r[0], r[1], r[2], r[4]);
+		setE_elem(e, r[0], r[1], r[4]);
+		if (r[3])
+			makeAnc(h, NULL);
+	}
+	for (k = 0; k < nf; k++)
 	{
-		sscanf(aux, "(%d,%d,%d,%d)", &i, &j, &val, &check);
-		addToTail(stk, i, j, val, check);
-		ch = fgetc(fp);
+		r = &fut[5 * k];
+		jogada(h, r[0], r[1], getE_elem(e, r[0], r[1]), r[2]);
+		setE_elem(e, r[0], r[1], r[2]);
 	}
-	return stk;
+	for (k = 0; k < nf; k++)
+		pipestack(e, 0);
+
+	free(past);
+	free(fut);
+	if (fscanf(fp, "ANCORAS:") != EOF)
+		readAnc(fp, h, 1);
+	return 1;
+}
+
+/**
+\brief Lê a história de jogadas, com as linhas @b HISTORIA , @b NOS e @b ANCORAS .
+
+A linha @b HISTORIA indica o nó atual e o último nó alcançável por redo.
+
+@param fp Apontador para ficheiro, posicionado depois de @b HISTORIA: .
+@param h @c HISTORIA vazia onde será colocada a história lida.
+
+@returns 1 se a história foi lida, 0 caso contrário.
+
+@see readNos
+@see readAnc
+@see setH_atual
+*/
+static int readHistoria(FILE *fp, HISTORIA h)
+{
+	int atual, fim;
+	if (fscanf(fp, "%d %d\nNOS:", &atual, &fim) != 2)
+		return 0;
+	readNos(fp, h);
+	if (fscanf(fp, "ANCORAS:") != EOF)
+		readAnc(fp, h, 0);
+	return setH_atual(h, atual, fim);
 }
 
 /**
@@ -116,6 +962,7 @@ ESTADO file2estado_un(char *path, char *user, int *flag)
 	int r;
 	int i = 0, j = 0;
 	char ch;
+	char label[16];
 	char *aux = (char *)malloc(sizeof(char) * (strlen(path) + strlen(user) + strlen(".txt") + 1));
 	sprintf(aux, "%s%s%s", path, user, ".txt");
 
@@ -220,22 +1067,19 @@ ESTADO file2estado_un(char *path, char *user, int *flag)
 		}
 		i++;
 	}
-	r = fscanf(fp, "PASSADO:");
-	if (r == EOF)
-	{
-		free(aux);
-		*flag = 0;
-		return e;
-	}
-	setE_stack(e, readAll(fp), 0);
-	r = fscanf(fp, "FUTURO:");
-	if (r == EOF)
+	r = fscanf(fp, "%15[A-Z]:", label);
+	if (r == 1 && !strcmp(label, "HISTORIA"))
+		r = readHistoria(fp, getE_hist(e));
+	else if (r == 1 && !strcmp(label, "PASSADO"))
+		r = readLegado(fp, e);
+	else
+		r = 0;
+	if (!r)
 	{
 		free(aux);
 		*flag = 0;
 		return e;
 	}
-	setE_stack(e, readAll(fp), 1);
 	fclose(fp);
 	*flag = 1;
 	free(aux);
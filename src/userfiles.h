@@ -8,6 +8,7 @@
 
 #include "cgi.h"
 #include "estado.h"
+#include "sessoes.h"
 
 // ------------------------------------------------------------------------------
 
@@ -16,14 +17,31 @@
 @param user nome de utilizador
 @param flag Apontador para o inteiro onde irá ser colocado o valor da validade do ficheiro.
 */
-#define file2estado(user,flag) (file2estado_un(USER_PATH,user,&(flag)))
+#define file2estado(user,flag) (bin2estado_un(USER_PATH,user,&(flag)))
 
 /**
 \brief Macro para converter um estado em ficheiro
 @param user nome de utilizador
 @param e estado a guardar
 */
-#define estado2file(user,e) (estado2file_un(USER_PATH,user,e))
+#define estado2file(user,e) (estado2jnl_un(USER_PATH,user,e))
+
+/**
+\brief Macro para trancar um utilizador até ao fim do pedido
+@param user nome de utilizador
+@param exclusivo diferente de 0 caso o pedido altere o estado
+*/
+#define trancaUser(user,exclusivo) (trancaUser_un(USER_PATH,user,exclusivo))
+
+/**
+\brief Macro para escrever no armazém as sessões alteradas há mais de @c SESSOES_ATRASO segundos
+*/
+#define varreSessoes() (varreSessoes_un(USER_PATH,SESSOES_ATRASO))
+
+/**
+\brief Tamanho, em bytes, a partir do qual o journal de um utilizador é compactado no ficheiro binário.
+*/
+#define JNL_MAX 65536
 
 // ------------------------------------------------------------------------------
 
@@ -31,4 +49,14 @@ ESTADO file2estado_un (char * path, char * user, int * flag);
 
 void estado2file_un (char * path, char * user, ESTADO e);
 
+ESTADO bin2estado_un (char * path, char * user, int * flag);
+
+void estado2bin_un (char * path, char * user, ESTADO e);
+
+void estado2jnl_un (char * path, char * user, ESTADO e);
+
+void trancaUser_un (char * path, char * user, int exclusivo);
+
+void varreSessoes_un (char * path, int atraso);
+
 #endif